@@ -0,0 +1,105 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <vulkan/vulkan.h>
+
+// Number of submissions that can be in flight at once
+#define SUBMIT_RING_SIZE 4
+
+// Ring of pre-created fences and resettable command buffers, reused for every submission
+typedef struct vk_submit_context {
+    VkCommandPool command_pool;
+    VkCommandBuffer command_buffers[SUBMIT_RING_SIZE];
+    VkFence fences[SUBMIT_RING_SIZE];
+    uint32_t next;
+} vk_submit_context;
+
+VkDescriptorSet vk_create_descriptor_set(
+    VkDevice vk_device,
+    VkDescriptorSetLayout vk_descriptor_set_layout,
+    VkDescriptorPool vk_descriptor_pool
+);
+
+// Records the dispatch, the optional timestamps and the readback into a command buffer being recorded
+void vk_record_dispatch(
+    VkCommandBuffer vk_command_buffer,
+    VkPipeline vk_pipeline,
+    VkPipelineLayout vk_pipeline_layout,
+    VkDescriptorSet vk_descriptor_set,
+    const void* push_constants,
+    uint32_t push_constants_size,
+    uint32_t group_count_x,
+    uint32_t group_count_y,
+    VkQueryPool vk_query_pool,
+    uint32_t vk_query_index,
+    VkBuffer vk_output_buffer,
+    VkBuffer vk_staging_buffer,     // VK_NULL_HANDLE when the output buffer is read directly
+    VkDeviceSize readback_size
+);
+
+// Makes the shader writes visible to host reads, copying the output into the staging buffer when there is one
+void vk_record_output_barrier(VkCommandBuffer vk_command_buffer, VkBuffer vk_output_buffer, VkBuffer vk_staging_buffer, VkDeviceSize readback_size);
+
+// Copies the output into the staging buffer and makes the copy visible to host reads
+void vk_record_readback(VkCommandBuffer vk_command_buffer, VkBuffer vk_output_buffer, VkBuffer vk_staging_buffer, VkDeviceSize readback_size);
+
+// Allocates a one-time command buffer holding a single dispatch
+VkCommandBuffer vk_prepare_command_buffer(
+    VkDevice vk_device,
+    VkPipeline vk_pipeline,
+    VkPipelineLayout vk_pipeline_layout,
+    VkDescriptorSet vk_descriptor_set,
+    VkCommandPool vk_compute_cmd_pool,
+    const void* push_constants,
+    uint32_t push_constants_size,
+    uint32_t group_count_x,
+    uint32_t group_count_y,
+    VkQueryPool vk_query_pool,
+    uint32_t vk_query_index,
+    VkBuffer vk_output_buffer,
+    VkBuffer vk_staging_buffer,
+    VkDeviceSize readback_size
+);
+
+// Submits and waits on a fence created for this call only
+int vk_compute(VkDevice vk_device, VkQueue vk_queue_compute, VkCommandBuffer vk_command_buffer);
+
+int vk_create_submit_context(VkDevice vk_device, uint32_t vk_queue_family_index, vk_submit_context* context);
+void vk_destroy_submit_context(VkDevice vk_device, vk_submit_context* context);
+
+// Waits until the next slot is free and begins recording its command buffer
+VkCommandBuffer vk_begin_submit(VkDevice vk_device, vk_submit_context* context);
+// Ends the command buffer returned by vk_begin_submit and submits it without waiting. A failed submission
+// leaves the slot with a signaled fence, so waiting on it afterwards returns.
+int vk_end_submit(VkDevice vk_device, VkQueue vk_queue_compute, vk_submit_context* context);
+// vk_end_submit for a submission ordered against another queue, the semaphores may be VK_NULL_HANDLE
+int vk_end_submit_semaphores(
+    VkDevice vk_device,
+    VkQueue vk_queue,
+    vk_submit_context* context,
+    VkSemaphore vk_wait_semaphore,
+    VkPipelineStageFlags wait_stage,
+    VkSemaphore vk_signal_semaphore
+);
+// Waits for the submission made from a given slot, the slot is context->next before vk_begin_submit
+int vk_wait_submit(VkDevice vk_device, vk_submit_context* context, uint32_t slot);
+// Waits for every submission in flight
+int vk_wait_submit_context(VkDevice vk_device, vk_submit_context* context);
+
+VkSemaphore vk_create_semaphore(VkDevice vk_device);
+
+VkQueryPool vk_create_timestamp_query_pool(VkDevice vk_device, uint32_t count);
+int vk_get_timestamp_ticks(
+    VkDevice vk_device,
+    VkQueryPool vk_query_pool,
+    uint32_t pair_count,
+    uint32_t valid_bits,
+    uint64_t* ticks
+);
+
+#ifdef __cplusplus
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <vulkan/vulkan.h>
+
+// Queues created from one family at most
+#define MAX_QUEUES_PER_FAMILY 4
+
+// Queues of the logical device. Transfer queues come from a transfer-only family (the DMA engine)
+// when there is one, else they are spare queues of the compute family. transfer_count is 0 when
+// the device has no queue to spare, copies then go through the compute queues.
+typedef struct vk_device_queues {
+    uint32_t compute_family;
+    uint32_t compute_count;
+    VkQueue compute[MAX_QUEUES_PER_FAMILY];
+    uint32_t transfer_family;
+    uint32_t transfer_count;
+    VkQueue transfer[MAX_QUEUES_PER_FAMILY];
+    int async_compute;      // The compute family has no graphics
+    int timeline_semaphores;    // Enabled on the device, see vkrt/scheduler.h
+} vk_device_queues;
+
+// Prefers a compute family without graphics (async compute) and a transfer family without compute.
+// Enables timeline semaphores when the device has them.
+VkDevice vk_create_device_and_queues(
+    VkPhysicalDevice vk_phy_device,
+    vk_device_queues* queues
+);
+
+VkCommandPool vk_create_command_pool(
+    VkDevice vk_device, 
+    uint32_t vk_queue_family_index
+);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,23 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <vulkan/vulkan.h>
+
+#define MAX_PHY_DEVICE 8
+#define MAX_QUEUE_FAMILY 32
+
+extern const char* vk_validation_layers[];
+
+VkInstance vk_create_instance();
+VkPhysicalDevice vk_create_physical_device(VkInstance instance);
+// Every physical device without printing or prompting, CPU implementations such as lavapipe included
+uint32_t vk_enumerate_physical_devices(VkInstance instance, VkPhysicalDevice* devices, uint32_t max_count);
+// vk_create_physical_device without the prompt, device_index -1 asks on stdin
+VkPhysicalDevice vk_select_physical_device(VkInstance instance, int device_index);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <vulkan/vulkan.h>
+
+// Layout of binding_count storage buffers at bindings 0 .. binding_count - 1, visible to compute
+VkDescriptorSetLayout vk_create_storage_set_layout(VkDevice vk_device, uint32_t binding_count);
+
+// Pool for max_sets descriptor sets of storage_buffers_per_set storage buffers each
+VkDescriptorPool vk_create_descriptor_pool(VkDevice vk_device, uint32_t max_sets, uint32_t storage_buffers_per_set);
+
+VkPipelineLayout vk_create_pipeline_layout(VkDevice vk_device, VkDescriptorSetLayout vk_descriptor_set_layout, uint32_t push_constants_size);
+
+// Loads the SPIR-V through spirv_load, so embedded shaders are found first
+VkShaderModule vk_create_compute_shader(VkDevice vk_device, const char* filename);
+
+// The shader module stays owned by the caller, specialization may be NULL
+VkPipeline vk_create_pipline(VkDevice vk_device, VkPipelineLayout vk_pipeline_layout, VkDescriptorSetLayout vk_descriptor_set_layout, VkShaderModule vk_shader_module,
+                             VkPipelineCache vk_pipeline_cache, const VkSpecializationInfo* specialization);
+
+#ifdef __cplusplus
+}
+#endif
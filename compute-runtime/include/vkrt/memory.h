@@ -0,0 +1,66 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <vulkan/vulkan.h>
+
+// Host-visible allocation that stays mapped for its whole lifetime
+typedef struct vk_mapped_memory {
+	VkDeviceMemory memory;
+	void* address;
+	VkDeviceSize size;
+	VkDeviceSize atom_size;		// nonCoherentAtomSize, 0 when the memory is coherent
+} vk_mapped_memory;
+
+// Where vk_create_buffer_and_memory places a buffer
+typedef enum vk_memory_placement {
+	MEMORY_PLACEMENT_HOST = 0,		// host-visible, coherent preferred
+	MEMORY_PLACEMENT_HOST_CACHED,	// host-visible, cached preferred for fast host reads (readback staging)
+	MEMORY_PLACEMENT_DEVICE,		// device-local, host-visible only on unified memory
+	MEMORY_PLACEMENT_DEVICE_MAPPED	// device-local and host-visible (ReBAR / unified), else host-visible
+} vk_memory_placement;
+
+// First memory type allowed by the mask that has all the flags, VK_MAX_MEMORY_TYPES if there is none
+uint32_t vk_find_memory_type(VkPhysicalDevice vk_phy_device, uint32_t allowedTypesMask, VkMemoryPropertyFlags flags);
+
+VkBuffer vk_create_buffer_and_memory(
+	VkPhysicalDevice vk_phy_device,
+	VkDevice vk_device, 
+	uint32_t size, 
+	VkBufferUsageFlags usage,
+	vk_memory_placement placement,
+	vk_mapped_memory* deviceMemory
+);
+
+// vk_create_buffer_and_memory for a buffer used by queues of several families
+VkBuffer vk_create_shared_buffer_and_memory(
+	VkPhysicalDevice vk_phy_device,
+	VkDevice vk_device,
+	uint32_t size,
+	VkBufferUsageFlags usage,
+	vk_memory_placement placement,
+	uint32_t queue_family_count,
+	const uint32_t* queue_families,
+	vk_mapped_memory* deviceMemory
+);
+
+void vk_destroy_buffer(VkDevice vk_device, VkBuffer vk_buffer, vk_mapped_memory* vk_buffer_memory);
+
+void vk_destroy_buffers(VkDevice vk_device,
+	VkBuffer vk_input_buffer, VkBuffer vk_output_buffer,
+	vk_mapped_memory* vk_input_buffer_memory, vk_mapped_memory* vk_output_buffer_memory
+);
+
+// Make host writes to [offset, offset + size) visible to the device, no-op for coherent memory
+void vk_flush_mapped_memory(VkDevice vk_device, const vk_mapped_memory* memory, VkDeviceSize offset, VkDeviceSize size);
+// Make device writes to [offset, offset + size) visible to the host, no-op for coherent memory
+void vk_invalidate_mapped_memory(VkDevice vk_device, const vk_mapped_memory* memory, VkDeviceSize offset, VkDeviceSize size);
+
+void vk_copy_to_input_buffer(VkDevice vk_device, void* data, uint32_t size, const vk_mapped_memory* vk_input_buffer_memory);
+void vk_copy_from_output_buffer(VkDevice vk_device, void* data, uint32_t size, const vk_mapped_memory* vk_output_buffer_memory);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,20 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <vulkan/vulkan.h>
+
+// Default location of the on-disk pipeline cache, relative to the working directory
+#define PIPELINE_CACHE_FILE "pipeline.cache"
+
+// Creates a pipeline cache seeded from filename when the file was written for this device and driver
+VkPipelineCache vk_create_pipeline_cache(VkPhysicalDevice vk_phy_device, VkDevice vk_device, const char* filename, int* warm);
+
+// Writes the cache contents to filename, keyed by the current device and driver
+int vk_save_pipeline_cache(VkPhysicalDevice vk_phy_device, VkDevice vk_device, VkPipelineCache vk_pipeline_cache, const char* filename);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,291 @@
+#pragma once
+
+// Move-only owners for the objects of the C runtime. Constructors throw std::runtime_error when
+// creation fails, destructors release the handle. reset() releases early, for callers that must
+// destroy everything before the device goes away.
+
+#include <vulkan/vulkan.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "vkrt/compute.h"
+#include "vkrt/kernel.h"
+#include "vkrt/memory.h"
+#include "vkrt/pipeline_cache.h"
+#include "vkrt/scheduler.h"
+
+namespace vkrt {
+
+// Buffer and its memory, kept mapped whenever the placement ends up host-visible
+class Buffer {
+public:
+    Buffer() = default;
+    Buffer(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize size, VkBufferUsageFlags usage,
+           vk_memory_placement placement);
+    ~Buffer() { reset(); }
+
+    Buffer(Buffer&& other) noexcept { *this = std::move(other); }
+    Buffer& operator=(Buffer&& other) noexcept;
+    Buffer(const Buffer&) = delete;
+    Buffer& operator=(const Buffer&) = delete;
+
+    void reset();
+
+    VkBuffer handle() const { return buffer; }
+    VkDeviceSize size() const { return bytes; }
+    // nullptr for device-only memory
+    void* data() const { return memory.address; }
+    const vk_mapped_memory& mapped() const { return memory; }
+
+    // No-ops on coherent memory
+    void flush(VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE) const;
+    void invalidate(VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE) const;
+
+    VkDescriptorBufferInfo descriptor() const { return { buffer, 0, bytes }; }
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    VkBuffer buffer = VK_NULL_HANDLE;
+    vk_mapped_memory memory{};
+    VkDeviceSize bytes = 0;
+};
+
+// Pipeline cache loaded from a file written for this device and driver, saved explicitly
+class PipelineCache {
+public:
+    PipelineCache() = default;
+    PipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, const char* filename = PIPELINE_CACHE_FILE);
+    ~PipelineCache() { reset(); }
+
+    PipelineCache(PipelineCache&& other) noexcept { *this = std::move(other); }
+    PipelineCache& operator=(PipelineCache&& other) noexcept;
+    PipelineCache(const PipelineCache&) = delete;
+    PipelineCache& operator=(const PipelineCache&) = delete;
+
+    void reset();
+    bool save() const;
+
+    VkPipelineCache handle() const { return cache; }
+    // The file held data for this device, pipelines should build without compiling
+    bool warm() const { return wasWarm; }
+
+private:
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    VkDevice device = VK_NULL_HANDLE;
+    VkPipelineCache cache = VK_NULL_HANDLE;
+    std::string filename;
+    bool wasWarm = false;
+};
+
+// Compute pipeline over bindingCount storage buffers and a push constant block, with its layouts
+class Kernel {
+public:
+    Kernel() = default;
+    Kernel(VkDevice device, const char* filename, uint32_t bindingCount, uint32_t pushConstantsSize,
+           VkPipelineCache cache = VK_NULL_HANDLE, const VkSpecializationInfo* specialization = nullptr);
+    ~Kernel() { reset(); }
+
+    Kernel(Kernel&& other) noexcept { *this = std::move(other); }
+    Kernel& operator=(Kernel&& other) noexcept;
+    Kernel(const Kernel&) = delete;
+    Kernel& operator=(const Kernel&) = delete;
+
+    void reset();
+
+    VkPipeline pipeline() const { return computePipeline; }
+    VkPipelineLayout layout() const { return pipelineLayout; }
+    VkDescriptorSetLayout setLayout() const { return descriptorSetLayout; }
+    uint32_t bindingCount() const { return bindings; }
+
+    // Points the bindings of set at the buffers, in binding order
+    void bind(VkDescriptorSet set, const std::vector<VkDescriptorBufferInfo>& buffers) const;
+
+    // Binds the pipeline and the set, pushes the constants and records the dispatch
+    void dispatch(VkCommandBuffer commandBuffer, VkDescriptorSet set, const void* pushConstants,
+                  uint32_t groupCountX, uint32_t groupCountY = 1, uint32_t groupCountZ = 1) const;
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline computePipeline = VK_NULL_HANDLE;
+    uint32_t bindings = 0;
+    uint32_t pushSize = 0;
+};
+
+// Buffer descriptor at one binding of a set
+struct BufferBinding {
+    uint32_t binding;
+    VkDescriptorType type;
+    VkDescriptorBufferInfo buffer;
+};
+
+// Descriptor sets carved from a list of pools. A pool that runs out (VK_ERROR_OUT_OF_POOL_MEMORY or
+// VK_ERROR_FRAGMENTED_POOL) is retired and the next one holds twice as many sets, so callers never
+// size pools up front. descriptorsPerSet is the expected mix of one set, e.g. 1 uniform + 5 storage.
+class DescriptorAllocator {
+public:
+    DescriptorAllocator() = default;
+    DescriptorAllocator(VkDevice device, std::vector<VkDescriptorPoolSize> descriptorsPerSet,
+                        uint32_t frameCount = 1, uint32_t setsPerPool = 16);
+    ~DescriptorAllocator() { reset(); }
+
+    DescriptorAllocator(DescriptorAllocator&& other) noexcept { *this = std::move(other); }
+    DescriptorAllocator& operator=(DescriptorAllocator&& other) noexcept;
+    DescriptorAllocator(const DescriptorAllocator&) = delete;
+    DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+    // Destroys every pool, and with them every set handed out
+    void reset();
+
+    // Lives until reset
+    VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+
+    // Set of this layout pointing at these buffers, written on the first request only and
+    // returned as is afterwards. Lives until reset. Sets are cached by handle value, so a
+    // buffer destroyed before reset must be passed to invalidate first.
+    VkDescriptorSet get(VkDescriptorSetLayout layout, const std::vector<BufferBinding>& bindings);
+    // Forgets the cached sets pointing at a buffer, a new buffer with the same handle then gets
+    // a freshly written set. The forgotten sets stay allocated until reset.
+    void invalidate(VkBuffer buffer);
+
+    // Returns the pools of a frame for reuse, once the frame's submissions have completed
+    void beginFrame(uint32_t frame);
+    // Lives until the next beginFrame(frame)
+    VkDescriptorSet allocateForFrame(uint32_t frame, VkDescriptorSetLayout layout);
+
+    size_t poolCount() const;
+
+private:
+    struct PoolList {
+        std::vector<VkDescriptorPool> full;
+        VkDescriptorPool current = VK_NULL_HANDLE;
+    };
+
+    VkDescriptorPool acquirePool();
+    VkDescriptorSet allocate(PoolList& pools, VkDescriptorSetLayout layout);
+
+    VkDevice device = VK_NULL_HANDLE;
+    std::vector<VkDescriptorPoolSize> descriptorsPerSet;
+    uint32_t nextPoolSets = 0;
+    PoolList persistent;
+    std::vector<PoolList> frames;
+    std::vector<VkDescriptorPool> spare;        // Reset frame pools waiting to be reused
+    std::map<std::vector<uint64_t>, VkDescriptorSet> cache;
+};
+
+class Fence {
+public:
+    Fence() = default;
+    Fence(VkDevice device, bool signaled = false);
+    ~Fence() { reset(); }
+
+    Fence(Fence&& other) noexcept { *this = std::move(other); }
+    Fence& operator=(Fence&& other) noexcept;
+    Fence(const Fence&) = delete;
+    Fence& operator=(const Fence&) = delete;
+
+    void reset();
+
+    // Returns false on timeout
+    bool wait(uint64_t timeout = UINT64_MAX) const;
+    void unsignal() const;
+
+    VkFence handle() const { return fence; }
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+};
+
+class Semaphore {
+public:
+    Semaphore() = default;
+    explicit Semaphore(VkDevice device);
+    ~Semaphore() { reset(); }
+
+    Semaphore(Semaphore&& other) noexcept { *this = std::move(other); }
+    Semaphore& operator=(Semaphore&& other) noexcept;
+    Semaphore(const Semaphore&) = delete;
+    Semaphore& operator=(const Semaphore&) = delete;
+
+    void reset();
+
+    VkSemaphore handle() const { return semaphore; }
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    VkSemaphore semaphore = VK_NULL_HANDLE;
+};
+
+// vk_submit_context: SUBMIT_RING_SIZE command buffers and fences reused round robin
+class SubmitRing {
+public:
+    SubmitRing() = default;
+    SubmitRing(VkDevice device, uint32_t queueFamilyIndex);
+    ~SubmitRing() { reset(); }
+
+    SubmitRing(SubmitRing&& other) noexcept { *this = std::move(other); }
+    SubmitRing& operator=(SubmitRing&& other) noexcept;
+    SubmitRing(const SubmitRing&) = delete;
+    SubmitRing& operator=(const SubmitRing&) = delete;
+
+    // Waits for the submissions in flight before destroying the ring
+    void reset();
+
+    // Waits until the next slot is free and begins recording its command buffer
+    VkCommandBuffer begin();
+    // Submits the command buffer returned by begin without waiting
+    void submit(VkQueue queue, VkSemaphore wait = VK_NULL_HANDLE, VkPipelineStageFlags waitStage = 0,
+                VkSemaphore signal = VK_NULL_HANDLE);
+    // Waits for every submission in flight
+    void wait();
+
+    vk_submit_context* context() { return &ring; }
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    vk_submit_context ring{};
+};
+
+// vk_scheduler: submissions ordered by a timeline semaphore, submission n signals value n
+class Scheduler {
+public:
+    Scheduler() = default;
+    Scheduler(VkDevice device, uint32_t queueFamilyIndex, uint32_t depth = 0);
+    ~Scheduler() { reset(); }
+
+    Scheduler(Scheduler&& other) noexcept { *this = std::move(other); }
+    Scheduler& operator=(Scheduler&& other) noexcept;
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    // Waits for the submissions in flight before destroying the scheduler
+    void reset();
+
+    // Waits until the next command buffer is free and begins recording it
+    VkCommandBuffer begin();
+    // Submits the command buffer returned by begin once every wait is reached, returns its value
+    uint64_t submit(VkQueue queue, const std::vector<vk_timeline_wait>& waits = {});
+
+    // Makes a submission on another queue wait for value of this timeline
+    vk_timeline_wait after(uint64_t value, VkPipelineStageFlags stage) const { return { scheduler.timeline, value, stage }; }
+
+    uint64_t submitted() const { return scheduler.submitted; }
+    uint64_t completed() const { return vk_scheduler_completed(device, &scheduler); }
+    void wait(uint64_t value) const;
+    void wait() const { wait(scheduler.submitted); }
+
+    VkSemaphore timeline() const { return scheduler.timeline; }
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    vk_scheduler scheduler{};
+};
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <vulkan/vulkan.h>
+
+// Largest number of submissions a scheduler keeps in flight
+#define SCHEDULER_MAX_DEPTH 64
+
+// Dependency of a submission on the progress of a timeline, usually another queue's scheduler
+typedef struct vk_timeline_wait {
+    VkSemaphore timeline;
+    uint64_t value;
+    VkPipelineStageFlags stage;
+} vk_timeline_wait;
+
+// Submissions to one queue ordered by a timeline semaphore: submission n signals value n, so the
+// progress of the queue is a single counter the host can read and wait on, and other submissions
+// can wait on. A command buffer is recycled once the timeline has passed its last value, without fences.
+// Every submission of a scheduler goes to the same queue, so its values complete in order.
+typedef struct vk_scheduler {
+    VkSemaphore timeline;
+    VkCommandPool command_pool;
+    VkCommandBuffer command_buffers[SCHEDULER_MAX_DEPTH];
+    uint32_t depth;
+    uint64_t submitted;     // Value of the last submission, 0 before the first
+} vk_scheduler;
+
+// Vulkan 1.2 with the timelineSemaphore feature, which vk_create_device_and_queues then enables
+int vk_timeline_semaphores_supported(VkPhysicalDevice vk_phy_device);
+
+VkSemaphore vk_create_timeline_semaphore(VkDevice vk_device, uint64_t initial_value);
+// Returns -1 on timeout or failure
+int vk_wait_timeline(VkDevice vk_device, VkSemaphore vk_timeline, uint64_t value, uint64_t timeout);
+// Moves the timeline forward from the host, releasing the submissions waiting for value
+int vk_signal_timeline(VkDevice vk_device, VkSemaphore vk_timeline, uint64_t value);
+uint64_t vk_timeline_value(VkDevice vk_device, VkSemaphore vk_timeline);
+
+// depth 0 uses SUBMIT_RING_SIZE submissions in flight
+int vk_create_scheduler(VkDevice vk_device, uint32_t vk_queue_family_index, uint32_t depth, vk_scheduler* scheduler);
+// Waits for every submission before destroying the scheduler
+void vk_destroy_scheduler(VkDevice vk_device, vk_scheduler* scheduler);
+
+// Waits until the command buffer of the next submission is free and begins recording it
+VkCommandBuffer vk_scheduler_begin(VkDevice vk_device, vk_scheduler* scheduler);
+// Ends the command buffer returned by vk_scheduler_begin and submits it once every wait is reached.
+// Returns the value the submission signals, or 0 on failure.
+uint64_t vk_scheduler_submit(VkQueue vk_queue, vk_scheduler* scheduler, const vk_timeline_wait* waits, uint32_t wait_count);
+// Value of the last submission that completed
+uint64_t vk_scheduler_completed(VkDevice vk_device, const vk_scheduler* scheduler);
+// Waits until the submission that signals value has completed
+int vk_scheduler_wait(VkDevice vk_device, const vk_scheduler* scheduler, uint64_t value);
+// Waits for every submission
+int vk_scheduler_wait_idle(VkDevice vk_device, const vk_scheduler* scheduler);
+
+#ifdef __cplusplus
+}
+#endif
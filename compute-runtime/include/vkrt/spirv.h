@@ -0,0 +1,41 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SPIRV_MAGIC 0x07230203u
+// Magic, version, generator, bound and schema words
+#define SPIRV_HEADER_WORDS 5
+
+// SPIR-V words ready for vkCreateShaderModule, either linked into the binary or a mapped file
+typedef struct spirv_code {
+    const uint32_t* words;
+    size_t size;            // In bytes
+    void* mapping;          // The mapped file, NULL for embedded shaders
+} spirv_code;
+
+// SPIR-V linked into the executable, looked up by the file name it would otherwise be loaded from
+typedef struct spirv_embedded_shader {
+    const char* filename;
+    const uint32_t* words;
+    size_t size;            // In bytes
+} spirv_embedded_shader;
+
+// Registers the executable's embedded shaders, the table must outlive every spirv_load
+void spirv_set_embedded_shaders(const spirv_embedded_shader* shaders, size_t count);
+
+// Checks the size, alignment and magic number, returns -1 and prints why if the code can't be SPIR-V
+int spirv_validate(const char* name, const void* code, size_t size);
+
+// Returns the embedded shader registered under filename if there is one, else maps the file.
+// The code stays valid until spirv_free.
+int spirv_load(const char* filename, spirv_code* code);
+void spirv_free(spirv_code* code);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,471 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "vkrt/compute.h"
+#include <string.h>
+#include <stdio.h>
+#include "vkrt/device.h"
+
+void vk_record_dispatch(
+    VkCommandBuffer vk_command_buffer,
+    VkPipeline vk_pipeline,
+    VkPipelineLayout vk_pipeline_layout,
+    VkDescriptorSet vk_descriptor_set,
+    const void* push_constants,
+    uint32_t push_constants_size,
+    uint32_t group_count_x,
+    uint32_t group_count_y,
+    VkQueryPool vk_query_pool,
+    uint32_t vk_query_index,
+    VkBuffer vk_output_buffer,
+    VkBuffer vk_staging_buffer,
+    VkDeviceSize readback_size)
+{
+    // Bracket the dispatch with a pair of timestamps when profiling
+    if (vk_query_pool != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(vk_command_buffer, vk_query_pool, vk_query_index, 2);
+        vkCmdWriteTimestamp(vk_command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, vk_query_pool, vk_query_index);
+    }
+
+    // A copy of the previous submission may still be reading the output buffer when submissions overlap
+    if (vk_staging_buffer != VK_NULL_HANDLE)
+    {
+        vkCmdPipelineBarrier(vk_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                             0, NULL, 0, NULL, 0, NULL);
+    }
+
+    vkCmdBindPipeline(vk_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, vk_pipeline);
+    vkCmdBindDescriptorSets(vk_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, vk_pipeline_layout,
+                            0, 1, &vk_descriptor_set, 0, NULL);
+    if (push_constants_size > 0)
+    {
+        vkCmdPushConstants(vk_command_buffer, vk_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT,
+                           0, push_constants_size, push_constants);
+    }
+    vkCmdDispatch(vk_command_buffer, group_count_x, group_count_y, 1);
+
+    if (vk_query_pool != VK_NULL_HANDLE)
+    {
+        vkCmdWriteTimestamp(vk_command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, vk_query_pool, vk_query_index + 1);
+    }
+
+    vk_record_output_barrier(vk_command_buffer, vk_output_buffer, vk_staging_buffer, readback_size);
+}
+
+void vk_record_output_barrier(VkCommandBuffer vk_command_buffer, VkBuffer vk_output_buffer, VkBuffer vk_staging_buffer, VkDeviceSize readback_size)
+{
+    VkMemoryBarrier memoryBarrier;
+    memset(&memoryBarrier, 0, sizeof(memoryBarrier));
+    memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+
+    if (vk_staging_buffer != VK_NULL_HANDLE)
+    {
+        // Device-local output: copy it into the host-visible staging buffer
+        memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        memoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        vkCmdPipelineBarrier(vk_command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                             1, &memoryBarrier, 0, NULL, 0, NULL);
+
+        vk_record_readback(vk_command_buffer, vk_output_buffer, vk_staging_buffer, readback_size);
+    }
+    else
+    {
+        // Make the shader writes available to host reads through the mapped pointer
+        memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        memoryBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(vk_command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+                             1, &memoryBarrier, 0, NULL, 0, NULL);
+    }
+}
+
+void vk_record_readback(VkCommandBuffer vk_command_buffer, VkBuffer vk_output_buffer, VkBuffer vk_staging_buffer, VkDeviceSize readback_size)
+{
+    VkBufferCopy region;
+    memset(&region, 0, sizeof(region));
+    region.size = readback_size;
+    vkCmdCopyBuffer(vk_command_buffer, vk_output_buffer, vk_staging_buffer, 1, &region);
+
+    VkMemoryBarrier memoryBarrier;
+    memset(&memoryBarrier, 0, sizeof(memoryBarrier));
+    memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(vk_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+                         1, &memoryBarrier, 0, NULL, 0, NULL);
+}
+
+VkCommandBuffer vk_prepare_command_buffer(
+    VkDevice vk_device, 
+    VkPipeline vk_pipeline, 
+    VkPipelineLayout vk_pipeline_layout, 
+    VkDescriptorSet vk_descriptor_set,
+    VkCommandPool vk_compute_cmd_pool,
+    const void* push_constants,
+    uint32_t push_constants_size,
+    uint32_t group_count_x,
+    uint32_t group_count_y,
+    VkQueryPool vk_query_pool,
+    uint32_t vk_query_index,
+    VkBuffer vk_output_buffer,
+    VkBuffer vk_staging_buffer,
+    VkDeviceSize readback_size)
+{
+    VkCommandBufferAllocateInfo allocInfo;
+    memset(&allocInfo, 0, sizeof(allocInfo));
+
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = vk_compute_cmd_pool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+
+	VkCommandBuffer vk_command_buffer;
+    if (vkAllocateCommandBuffers(vk_device, &allocInfo, &vk_command_buffer) != VK_SUCCESS)
+    {
+        printf("Failed to allocate the buffer\n");
+        return VK_NULL_HANDLE;
+    }
+
+    VkCommandBufferBeginInfo beginInfo;
+    memset(&beginInfo, 0, sizeof(beginInfo));
+
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    if (vkBeginCommandBuffer(vk_command_buffer, &beginInfo) != VK_SUCCESS)
+    {
+        printf("Failed to begin the buffer\n");
+        return VK_NULL_HANDLE;
+    }
+
+    vk_record_dispatch(vk_command_buffer, vk_pipeline, vk_pipeline_layout, vk_descriptor_set, push_constants, push_constants_size,
+                       group_count_x, group_count_y, vk_query_pool, vk_query_index, vk_output_buffer, vk_staging_buffer, readback_size);
+
+    if (vkEndCommandBuffer(vk_command_buffer) != VK_SUCCESS)
+    {
+        printf("Failed to end the buffer\n");
+        return VK_NULL_HANDLE;
+    }
+
+	return vk_command_buffer;
+}
+
+int vk_compute(VkDevice vk_device, VkQueue vk_queue_compute, VkCommandBuffer vk_command_buffer)
+{
+    VkFenceCreateInfo fenceCreateInfo;
+    memset(&fenceCreateInfo, 0, sizeof(fenceCreateInfo));
+
+    fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    VkFence fence;
+    if (vkCreateFence(vk_device, &fenceCreateInfo, NULL, &fence) != VK_SUCCESS)
+    {
+        printf("Failed to create a fence.\n");
+    }
+
+    VkSubmitInfo submitInfo;
+    memset(&submitInfo, 0, sizeof(submitInfo));
+
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &vk_command_buffer;
+
+    if (vkQueueSubmit(vk_queue_compute, 1, &submitInfo, fence) != VK_SUCCESS)
+    {
+        printf("Submitting the command buffer failed\n");
+        return -1;
+    }
+
+    if (vkWaitForFences(vk_device, 1, &fence, VK_TRUE, 1000000000) != VK_SUCCESS)
+    {
+        printf("Failed to wait for the fence.\n");
+    }
+
+    vkDestroyFence(vk_device, fence, NULL);
+
+    return 0;
+}
+
+int vk_create_submit_context(VkDevice vk_device, uint32_t vk_queue_family_index, vk_submit_context* context)
+{
+    memset(context, 0, sizeof(*context));
+
+    // Command buffers are re-recorded in place instead of being freed
+    VkCommandPoolCreateInfo poolCreateInfo;
+    memset(&poolCreateInfo, 0, sizeof(poolCreateInfo));
+
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolCreateInfo.queueFamilyIndex = vk_queue_family_index;
+
+    if (vkCreateCommandPool(vk_device, &poolCreateInfo, NULL, &context->command_pool) != VK_SUCCESS)
+    {
+        printf("Failed to create the submission command pool.\n");
+        return -1;
+    }
+
+    VkCommandBufferAllocateInfo allocInfo;
+    memset(&allocInfo, 0, sizeof(allocInfo));
+
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = context->command_pool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = SUBMIT_RING_SIZE;
+
+    if (vkAllocateCommandBuffers(vk_device, &allocInfo, context->command_buffers) != VK_SUCCESS)
+    {
+        printf("Failed to allocate the submission command buffers.\n");
+        vk_destroy_submit_context(vk_device, context);
+        return -1;
+    }
+
+    // Fences start signaled so the first use of every slot doesn't wait
+    VkFenceCreateInfo fenceCreateInfo;
+    memset(&fenceCreateInfo, 0, sizeof(fenceCreateInfo));
+
+    fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    for (uint32_t i = 0; i < SUBMIT_RING_SIZE; i++)
+    {
+        if (vkCreateFence(vk_device, &fenceCreateInfo, NULL, &context->fences[i]) != VK_SUCCESS)
+        {
+            printf("Failed to create a fence.\n");
+            vk_destroy_submit_context(vk_device, context);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void vk_destroy_submit_context(VkDevice vk_device, vk_submit_context* context)
+{
+    for (uint32_t i = 0; i < SUBMIT_RING_SIZE; i++)
+    {
+        if (context->fences[i] != VK_NULL_HANDLE)
+        {
+            vkDestroyFence(vk_device, context->fences[i], NULL);
+        }
+    }
+    if (context->command_pool != VK_NULL_HANDLE)
+    {
+        vkDestroyCommandPool(vk_device, context->command_pool, NULL);
+    }
+    memset(context, 0, sizeof(*context));
+}
+
+VkCommandBuffer vk_begin_submit(VkDevice vk_device, vk_submit_context* context)
+{
+    uint32_t slot = context->next;
+    if (context->fences[slot] == VK_NULL_HANDLE)
+    {
+        printf("The slot has no fence.\n");
+        return VK_NULL_HANDLE;
+    }
+
+    // The slot is free once its previous submission has retired
+    if (vkWaitForFences(vk_device, 1, &context->fences[slot], VK_TRUE, UINT64_MAX) != VK_SUCCESS)
+    {
+        printf("Failed to wait for the fence.\n");
+        return VK_NULL_HANDLE;
+    }
+
+    VkCommandBufferBeginInfo beginInfo;
+    memset(&beginInfo, 0, sizeof(beginInfo));
+
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    // Beginning implicitly resets the buffer
+    if (vkBeginCommandBuffer(context->command_buffers[slot], &beginInfo) != VK_SUCCESS)
+    {
+        printf("Failed to begin the buffer\n");
+        return VK_NULL_HANDLE;
+    }
+    return context->command_buffers[slot];
+}
+
+int vk_end_submit(VkDevice vk_device, VkQueue vk_queue_compute, vk_submit_context* context)
+{
+    return vk_end_submit_semaphores(vk_device, vk_queue_compute, context, VK_NULL_HANDLE, 0, VK_NULL_HANDLE);
+}
+
+int vk_end_submit_semaphores(
+    VkDevice vk_device,
+    VkQueue vk_queue,
+    vk_submit_context* context,
+    VkSemaphore vk_wait_semaphore,
+    VkPipelineStageFlags wait_stage,
+    VkSemaphore vk_signal_semaphore)
+{
+    uint32_t slot = context->next;
+
+    if (vkEndCommandBuffer(context->command_buffers[slot]) != VK_SUCCESS)
+    {
+        printf("Failed to end the buffer\n");
+        return -1;
+    }
+
+    vkResetFences(vk_device, 1, &context->fences[slot]);
+
+    VkSubmitInfo submitInfo;
+    memset(&submitInfo, 0, sizeof(submitInfo));
+
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &context->command_buffers[slot];
+    if (vk_wait_semaphore != VK_NULL_HANDLE)
+    {
+        submitInfo.waitSemaphoreCount = 1;
+        submitInfo.pWaitSemaphores = &vk_wait_semaphore;
+        submitInfo.pWaitDstStageMask = &wait_stage;
+    }
+    if (vk_signal_semaphore != VK_NULL_HANDLE)
+    {
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &vk_signal_semaphore;
+    }
+
+    if (vkQueueSubmit(vk_queue, 1, &submitInfo, context->fences[slot]) != VK_SUCCESS)
+    {
+        printf("Submitting the command buffer failed\n");
+
+        // Nothing will signal the reset fence, so the slot gets a signaled one and later waits return
+        VkFenceCreateInfo fenceCreateInfo;
+        memset(&fenceCreateInfo, 0, sizeof(fenceCreateInfo));
+
+        fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+        vkDestroyFence(vk_device, context->fences[slot], NULL);
+        context->fences[slot] = VK_NULL_HANDLE;
+        if (vkCreateFence(vk_device, &fenceCreateInfo, NULL, &context->fences[slot]) != VK_SUCCESS)
+        {
+            printf("Failed to create a fence.\n");
+        }
+        return -1;
+    }
+
+    context->next = (slot + 1) % SUBMIT_RING_SIZE;
+    return 0;
+}
+
+int vk_wait_submit(VkDevice vk_device, vk_submit_context* context, uint32_t slot)
+{
+    // A slot without a fence lost it to a failed submission and has nothing in flight
+    if (context->fences[slot] == VK_NULL_HANDLE)
+    {
+        return 0;
+    }
+    if (vkWaitForFences(vk_device, 1, &context->fences[slot], VK_TRUE, UINT64_MAX) != VK_SUCCESS)
+    {
+        printf("Failed to wait for the fence.\n");
+        return -1;
+    }
+    return 0;
+}
+
+int vk_wait_submit_context(VkDevice vk_device, vk_submit_context* context)
+{
+    VkFence fences[SUBMIT_RING_SIZE];
+    uint32_t fence_count = 0;
+    for (uint32_t i = 0; i < SUBMIT_RING_SIZE; i++)
+    {
+        if (context->fences[i] != VK_NULL_HANDLE)
+        {
+            fences[fence_count++] = context->fences[i];
+        }
+    }
+    if (fence_count > 0 && vkWaitForFences(vk_device, fence_count, fences, VK_TRUE, UINT64_MAX) != VK_SUCCESS)
+    {
+        printf("Failed to wait for the fences.\n");
+        return -1;
+    }
+    return 0;
+}
+
+VkSemaphore vk_create_semaphore(VkDevice vk_device)
+{
+    VkSemaphoreCreateInfo semaphoreCreateInfo;
+    memset(&semaphoreCreateInfo, 0, sizeof(semaphoreCreateInfo));
+    semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    VkSemaphore vk_semaphore = VK_NULL_HANDLE;
+    if (vkCreateSemaphore(vk_device, &semaphoreCreateInfo, NULL, &vk_semaphore) != VK_SUCCESS)
+    {
+        printf("Failed to create a semaphore.\n");
+        return VK_NULL_HANDLE;
+    }
+    return vk_semaphore;
+}
+
+VkQueryPool vk_create_timestamp_query_pool(VkDevice vk_device, uint32_t count)
+{
+    VkQueryPoolCreateInfo queryPoolCreateInfo;
+    memset(&queryPoolCreateInfo, 0, sizeof(queryPoolCreateInfo));
+
+    queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolCreateInfo.queryCount = count;
+
+    VkQueryPool vk_query_pool = VK_NULL_HANDLE;
+    if (vkCreateQueryPool(vk_device, &queryPoolCreateInfo, NULL, &vk_query_pool) != VK_SUCCESS)
+    {
+        printf("Failed to create a timestamp query pool.\n");
+        return VK_NULL_HANDLE;
+    }
+    return vk_query_pool;
+}
+
+// Sums (end - begin) over pair_count timestamp pairs starting at query 0
+int vk_get_timestamp_ticks(
+    VkDevice vk_device,
+    VkQueryPool vk_query_pool,
+    uint32_t pair_count,
+    uint32_t valid_bits,
+    uint64_t* ticks)
+{
+    uint64_t mask = (valid_bits >= 64) ? ~0ull : ((1ull << valid_bits) - 1);
+    uint64_t timestamps[2];
+
+    *ticks = 0;
+    for (uint32_t i = 0; i < pair_count; i++)
+    {
+        if (vkGetQueryPoolResults(vk_device, vk_query_pool, 2 * i, 2, sizeof(timestamps), timestamps, sizeof(uint64_t),
+                                  VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) != VK_SUCCESS)
+        {
+            printf("Failed to read the timestamp queries.\n");
+            return -1;
+        }
+        // Only the low valid_bits are meaningful, the counter may wrap in between
+        *ticks += (timestamps[1] - timestamps[0]) & mask;
+    }
+    return 0;
+}
+
+VkDescriptorSet vk_create_descriptor_set(
+    VkDevice vk_device, 
+    VkDescriptorSetLayout vk_descriptor_set_layout, 
+    VkDescriptorPool vk_descriptor_pool)
+{
+    VkDescriptorSet vk_descriptor_set = VK_NULL_HANDLE;
+
+    VkDescriptorSetAllocateInfo descriptorSetAllocInfo;
+    memset(&descriptorSetAllocInfo, 0, sizeof(descriptorSetAllocInfo));
+
+    descriptorSetAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    descriptorSetAllocInfo.descriptorSetCount = 1;
+    descriptorSetAllocInfo.pSetLayouts = &vk_descriptor_set_layout;
+    descriptorSetAllocInfo.descriptorPool = vk_descriptor_pool;
+
+    if (vkAllocateDescriptorSets(vk_device, &descriptorSetAllocInfo, &vk_descriptor_set) != VK_SUCCESS)
+    {
+        printf("Failed to allocate the descriptor set.");
+    }
+    return vk_descriptor_set;
+}
+
+#ifdef __cplusplus
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,159 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <string.h>
+#include <stdio.h>
+#include "vkrt/device.h"
+#include "vkrt/instance.h"
+#include "vkrt/memory.h"
+#include "vkrt/scheduler.h"
+
+// Returns the first family having all of the required flags and none of the excluded ones, or count
+static uint32_t find_queue_family(const VkQueueFamilyProperties* families, uint32_t count, VkQueueFlags required, VkQueueFlags excluded)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if ((families[i].queueFlags & required) == required && (families[i].queueFlags & excluded) == 0 && families[i].queueCount > 0)
+        {
+            return i;
+        }
+    }
+    return count;
+}
+
+static uint32_t min_u32(uint32_t a, uint32_t b)
+{
+    return a < b ? a : b;
+}
+
+VkDevice vk_create_device_and_queues(VkPhysicalDevice vk_phy_device, vk_device_queues* queues)
+{
+    memset(queues, 0, sizeof(*queues));
+
+    VkQueueFamilyProperties families[MAX_QUEUE_FAMILY];
+    uint32_t count = MAX_QUEUE_FAMILY;
+
+    vkGetPhysicalDeviceQueueFamilyProperties(vk_phy_device, &count, families);
+
+    printf("Found %u queue families\n", count);
+
+    // The graphics family is usually the first compute-capable one, kernels there compete with rendering
+    uint32_t compute_family = find_queue_family(families, count, VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT);
+    queues->async_compute = compute_family < count;
+    if (compute_family == count)
+    {
+        compute_family = find_queue_family(families, count, VK_QUEUE_COMPUTE_BIT, 0);
+    }
+    if (compute_family == count)
+    {
+        printf("Compute queue not found\n");
+        return VK_NULL_HANDLE;
+    }
+
+    // Copy engines expose families with transfer only
+    uint32_t transfer_family = find_queue_family(families, count, VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+
+    queues->compute_family = compute_family;
+    if (transfer_family < count)
+    {
+        queues->compute_count = min_u32(families[compute_family].queueCount, MAX_QUEUES_PER_FAMILY);
+        queues->transfer_family = transfer_family;
+        queues->transfer_count = min_u32(families[transfer_family].queueCount, MAX_QUEUES_PER_FAMILY);
+    }
+    else
+    {
+        // Split the compute family, compute keeps the extra queue of an odd count
+        uint32_t available = min_u32(families[compute_family].queueCount, 2 * MAX_QUEUES_PER_FAMILY);
+        queues->transfer_family = compute_family;
+        queues->transfer_count = available / 2;
+        queues->compute_count = available - queues->transfer_count;
+    }
+
+    float priorities[2 * MAX_QUEUES_PER_FAMILY];
+    for (uint32_t i = 0; i < 2 * MAX_QUEUES_PER_FAMILY; i++)
+    {
+        priorities[i] = 1.0f;
+    }
+
+    VkDeviceQueueCreateInfo queueCreateInfos[2];
+    memset(queueCreateInfos, 0, sizeof(queueCreateInfos));
+
+    uint32_t queue_create_count = 1;
+    queueCreateInfos[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueCreateInfos[0].queueFamilyIndex = compute_family;
+    queueCreateInfos[0].queueCount = queues->compute_count;
+    queueCreateInfos[0].pQueuePriorities = priorities;
+
+    if (transfer_family < count)
+    {
+        queueCreateInfos[1].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+        queueCreateInfos[1].queueFamilyIndex = transfer_family;
+        queueCreateInfos[1].queueCount = queues->transfer_count;
+        queueCreateInfos[1].pQueuePriorities = priorities;
+        queue_create_count = 2;
+    }
+    else
+    {
+        queueCreateInfos[0].queueCount += queues->transfer_count;
+    }
+
+    VkDeviceCreateInfo deviceCreateInfo;
+    memset(&deviceCreateInfo, 0, sizeof(deviceCreateInfo));
+
+    deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceCreateInfo.pQueueCreateInfos = queueCreateInfos;
+    deviceCreateInfo.queueCreateInfoCount = queue_create_count;
+
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures;
+    memset(&timelineFeatures, 0, sizeof(timelineFeatures));
+    timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+
+    queues->timeline_semaphores = vk_timeline_semaphores_supported(vk_phy_device);
+    if (queues->timeline_semaphores)
+    {
+        timelineFeatures.timelineSemaphore = VK_TRUE;
+        deviceCreateInfo.pNext = &timelineFeatures;
+    }
+
+    VkDevice vk_device;
+    if (vkCreateDevice(vk_phy_device, &deviceCreateInfo, NULL, &vk_device) != VK_SUCCESS)
+    {
+        printf("Failed to crate logical device\n");
+        return VK_NULL_HANDLE;
+    }
+
+    for (uint32_t i = 0; i < queues->compute_count; i++)
+    {
+        vkGetDeviceQueue(vk_device, compute_family, i, &queues->compute[i]);
+    }
+    // Spare compute family queues follow the compute ones
+    uint32_t first_transfer = transfer_family < count ? 0 : queues->compute_count;
+    for (uint32_t i = 0; i < queues->transfer_count; i++)
+    {
+        vkGetDeviceQueue(vk_device, queues->transfer_family, first_transfer + i, &queues->transfer[i]);
+    }
+
+	return vk_device;
+}
+ 
+VkCommandPool vk_create_command_pool(VkDevice vk_device, uint32_t vk_queue_family_index)
+{
+	VkCommandPool vk_compute_cmd_pool = VK_NULL_HANDLE;
+
+    VkCommandPoolCreateInfo poolCreateInfo;
+    memset(&poolCreateInfo, 0, sizeof(poolCreateInfo));
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolCreateInfo.queueFamilyIndex = vk_queue_family_index;
+
+    if (vkCreateCommandPool(vk_device, &poolCreateInfo, NULL, &vk_compute_cmd_pool) != VK_SUCCESS)
+    {
+        printf("Failed to create a command pool\n");
+		return VK_NULL_HANDLE;
+    }
+	return vk_compute_cmd_pool;
+}
+
+#ifdef __cplusplus
+}
+#endif
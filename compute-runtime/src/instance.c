@@ -5,7 +5,7 @@ extern "C" {
 #include <string.h>
 #include <stdio.h>
 
-#include "instance.h"
+#include "vkrt/instance.h"
 
 const char* vk_validation_layers[] = { "VK_LAYER_KHRONOS_validation" };
 
@@ -32,7 +32,26 @@ const char* vkPhysicalDeviceType_as_string(VkPhysicalDeviceType type) {
 	}
 }
 
+uint32_t vk_enumerate_physical_devices(VkInstance instance, VkPhysicalDevice* devices, uint32_t max_count)
+{
+    uint32_t physicalDeviceCount = 0;
+    vkEnumeratePhysicalDevices(instance, &physicalDeviceCount, NULL);
+    if (physicalDeviceCount > max_count)
+    {
+        physicalDeviceCount = max_count;
+    }
+
+    // VK_INCOMPLETE only means there are more than max_count
+    VkResult result = vkEnumeratePhysicalDevices(instance, &physicalDeviceCount, devices);
+    return result == VK_SUCCESS || result == VK_INCOMPLETE ? physicalDeviceCount : 0;
+}
+
 VkPhysicalDevice vk_create_physical_device(VkInstance instance)
+{
+    return vk_select_physical_device(instance, -1);
+}
+
+VkPhysicalDevice vk_select_physical_device(VkInstance instance, int device_index)
 {
     uint32_t physicalDeviceCount = 0;
     vkEnumeratePhysicalDevices(instance, &physicalDeviceCount, NULL);
@@ -109,8 +128,14 @@ VkPhysicalDevice vk_create_physical_device(VkInstance instance)
 		printf("\n");
 	}
 
-    int deviceIndex = -1;
-    printf("Choose a physical device:\n");
+    int deviceIndex = device_index;
+    if (deviceIndex >= (int)physicalDeviceCount) {
+        printf("There is no device %d.\n", deviceIndex);
+        return VK_NULL_HANDLE;
+    }
+    if (deviceIndex < 0) {
+        printf("Choose a physical device:\n");
+    }
     while (deviceIndex < 0 || deviceIndex >= physicalDeviceCount) {
         printf("Device index from 0 to %d:\n", -1 + physicalDeviceCount);
 		scanf("%d", &deviceIndex);
@@ -124,10 +149,25 @@ VkInstance vk_create_instance(void)
 {
     VkInstance vk_instance;
 
+    // Subgroup properties and other 1.1+ queries need a newer API version than the 1.0 default.
+    // A 1.0 loader rejects anything above 1.0, newer loaders accept any version.
+    VkApplicationInfo applicationInfo;
+    memset(&applicationInfo, 0, sizeof(applicationInfo));
+    applicationInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    applicationInfo.apiVersion = VK_API_VERSION_1_0;
+
+    PFN_vkEnumerateInstanceVersion enumerateInstanceVersion =
+        (PFN_vkEnumerateInstanceVersion)vkGetInstanceProcAddr(NULL, "vkEnumerateInstanceVersion");
+    if (enumerateInstanceVersion != NULL)
+    {
+        applicationInfo.apiVersion = VK_API_VERSION_1_2;
+    }
+
     VkInstanceCreateInfo instanceCreateInfo;
     memset(&instanceCreateInfo, 0, sizeof(instanceCreateInfo));
 
     instanceCreateInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    instanceCreateInfo.pApplicationInfo = &applicationInfo;
     instanceCreateInfo.ppEnabledLayerNames = vk_validation_layers;
     instanceCreateInfo.enabledLayerCount = 1;
 
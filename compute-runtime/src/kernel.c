@@ -0,0 +1,152 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "vkrt/kernel.h"
+#include "vkrt/spirv.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+VkDescriptorSetLayout vk_create_storage_set_layout(VkDevice vk_device, uint32_t binding_count)
+{
+    VkDescriptorSetLayoutBinding* bindings = (VkDescriptorSetLayoutBinding*)calloc(binding_count, sizeof(VkDescriptorSetLayoutBinding));
+    if (bindings == NULL)
+    {
+        return VK_NULL_HANDLE;
+    }
+
+    for (uint32_t i = 0; i < binding_count; i++)
+    {
+        bindings[i].binding = i;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+    }
+
+    VkDescriptorSetLayoutCreateInfo createInfo;
+    memset(&createInfo, 0, sizeof(createInfo));
+    createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    createInfo.bindingCount = binding_count;
+    createInfo.pBindings = bindings;
+
+    VkDescriptorSetLayout vk_descriptor_set_layout = VK_NULL_HANDLE;
+    if (vkCreateDescriptorSetLayout(vk_device, &createInfo, NULL, &vk_descriptor_set_layout) != VK_SUCCESS)
+    {
+        printf("Failed to create a descriptor set layout handle.\n");
+    }
+    free(bindings);
+    return vk_descriptor_set_layout;
+}
+
+VkDescriptorPool vk_create_descriptor_pool(VkDevice vk_device, uint32_t max_sets, uint32_t storage_buffers_per_set)
+{
+    VkDescriptorPool vk_descriptor_pool = VK_NULL_HANDLE;
+
+    VkDescriptorPoolSize descriptorPoolSize;
+    memset(&descriptorPoolSize, 0, sizeof(descriptorPoolSize));
+    descriptorPoolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorPoolSize.descriptorCount = storage_buffers_per_set * max_sets;
+
+    VkDescriptorPoolCreateInfo descriptorPoolCreateInfo;
+    memset(&descriptorPoolCreateInfo, 0, sizeof(descriptorPoolCreateInfo));
+    descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptorPoolCreateInfo.maxSets = max_sets;
+    descriptorPoolCreateInfo.pPoolSizes = &descriptorPoolSize;
+    descriptorPoolCreateInfo.poolSizeCount = 1;
+
+    if (vkCreateDescriptorPool(vk_device, &descriptorPoolCreateInfo, NULL, &vk_descriptor_pool) != VK_SUCCESS)
+    {
+        printf("Failed to create the descriptor pool.\n");
+    }
+
+    return vk_descriptor_pool;
+}
+
+VkShaderModule vk_create_compute_shader(VkDevice vk_device, const char* filename)
+{
+    spirv_code code;
+    if (spirv_load(filename, &code) != 0)
+    {
+        return VK_NULL_HANDLE;
+    }
+
+    VkShaderModuleCreateInfo createInfo;
+    memset(&createInfo, 0, sizeof(createInfo));
+
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = code.size;
+    createInfo.pCode = code.words;
+
+    VkShaderModule handle;
+    VkResult result = vkCreateShaderModule(vk_device, &createInfo, NULL, &handle);
+
+    // The driver has its own copy of the code now
+    spirv_free(&code);
+
+    if (result != VK_SUCCESS)
+    {
+        printf("Failed to create the shader module.\n");
+        return VK_NULL_HANDLE;
+    }
+    return handle;
+}
+
+VkPipelineLayout vk_create_pipeline_layout(VkDevice vk_device, VkDescriptorSetLayout vk_descriptor_set_layout, uint32_t push_constants_size)
+{
+	VkPipelineLayout vk_pipeline_layout;
+
+    VkPushConstantRange pushConstantRange;
+    memset(&pushConstantRange, 0, sizeof(pushConstantRange));
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = push_constants_size;
+
+    VkPipelineLayoutCreateInfo createLayout;
+    memset(&createLayout, 0, sizeof(createLayout));
+
+    createLayout.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    createLayout.pSetLayouts = &vk_descriptor_set_layout;
+    createLayout.setLayoutCount = 1;
+    if (push_constants_size > 0)
+    {
+        createLayout.pushConstantRangeCount = 1;
+        createLayout.pPushConstantRanges = &pushConstantRange;
+    }
+
+    if (vkCreatePipelineLayout(vk_device, &createLayout, NULL, &vk_pipeline_layout) != VK_SUCCESS)
+    {
+        printf("Failed to create the pipeline layout.\n");
+        return VK_NULL_HANDLE;
+    }
+	return vk_pipeline_layout;
+}
+ 
+VkPipeline vk_create_pipline(VkDevice vk_device, VkPipelineLayout vk_pipeline_layout, VkDescriptorSetLayout vk_descriptor_set_layout, VkShaderModule vk_shader_module,
+                             VkPipelineCache vk_pipeline_cache, const VkSpecializationInfo* specialization)
+{
+    VkPipeline vk_pipeline;
+
+    VkComputePipelineCreateInfo createPipeline;
+    memset(&createPipeline, 0, sizeof(createPipeline));
+    createPipeline.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    createPipeline.layout = vk_pipeline_layout;
+    createPipeline.basePipelineIndex = -1;
+    createPipeline.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    createPipeline.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    createPipeline.stage.pName = "main";
+    createPipeline.stage.module = vk_shader_module;
+    createPipeline.stage.pSpecializationInfo = specialization;
+
+    if (vkCreateComputePipelines(vk_device, vk_pipeline_cache, 1, &createPipeline, NULL, &vk_pipeline) != VK_SUCCESS)
+    {
+        printf("Failed to create a pipeline.\n");
+        return VK_NULL_HANDLE;
+    }
+
+	return vk_pipeline;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,260 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "vkrt/memory.h"
+#include "vkrt/device.h"
+#include <stdio.h>
+#include <string.h>
+
+#include "vkrt/instance.h"
+#include "vkrt/compute.h"
+
+static uint32_t find_memory_type(const VkPhysicalDeviceMemoryProperties* memProperties, uint32_t allowedTypesMask, VkMemoryPropertyFlags flags)
+{
+    uint32_t typeMask = 1;
+    for (uint32_t i = 0; i < memProperties->memoryTypeCount; i++, typeMask <<= 1)
+    {
+        if ((allowedTypesMask & typeMask) != 0)
+        {
+            if ((memProperties->memoryTypes[i].propertyFlags & flags) == flags)
+            {
+                return i;
+            }
+        }
+    }
+    return VK_MAX_MEMORY_TYPES;
+}
+
+// Returns the first memory type matching one of the candidate flag sets, in order of preference
+static uint32_t find_preferred_memory_type(const VkPhysicalDeviceMemoryProperties* memProperties, uint32_t allowedTypesMask,
+                                           const VkMemoryPropertyFlags* candidates, uint32_t candidate_count)
+{
+    for (uint32_t i = 0; i < candidate_count; i++)
+    {
+        uint32_t index = find_memory_type(memProperties, allowedTypesMask, candidates[i]);
+        if (index != VK_MAX_MEMORY_TYPES)
+        {
+            return index;
+        }
+    }
+    return VK_MAX_MEMORY_TYPES;
+}
+
+uint32_t vk_find_memory_type(VkPhysicalDevice vk_phy_device, uint32_t allowedTypesMask, VkMemoryPropertyFlags flags)
+{
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(vk_phy_device, &memProperties);
+
+    return find_memory_type(&memProperties, allowedTypesMask, flags);
+}
+
+// Expands [offset, offset + size) to nonCoherentAtomSize boundaries inside the allocation
+static void get_mapped_range(VkMappedMemoryRange* range, const vk_mapped_memory* memory, VkDeviceSize offset, VkDeviceSize size)
+{
+    VkDeviceSize begin = offset - offset % memory->atom_size;
+    VkDeviceSize end = offset + size;
+    end = (end + memory->atom_size - 1) / memory->atom_size * memory->atom_size;
+
+    memset(range, 0, sizeof(*range));
+    range->sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    range->memory = memory->memory;
+    range->offset = begin;
+    range->size = (end >= memory->size) ? VK_WHOLE_SIZE : end - begin;
+}
+
+void vk_flush_mapped_memory(VkDevice vk_device, const vk_mapped_memory* memory, VkDeviceSize offset, VkDeviceSize size)
+{
+    if (memory->atom_size == 0 || size == 0)
+    {
+        return;
+    }
+
+    VkMappedMemoryRange range;
+    get_mapped_range(&range, memory, offset, size);
+    if (vkFlushMappedMemoryRanges(vk_device, 1, &range) != VK_SUCCESS)
+    {
+        printf("Failed to flush mapped memory.\n");
+    }
+}
+
+void vk_invalidate_mapped_memory(VkDevice vk_device, const vk_mapped_memory* memory, VkDeviceSize offset, VkDeviceSize size)
+{
+    if (memory->atom_size == 0 || size == 0)
+    {
+        return;
+    }
+
+    VkMappedMemoryRange range;
+    get_mapped_range(&range, memory, offset, size);
+    if (vkInvalidateMappedMemoryRanges(vk_device, 1, &range) != VK_SUCCESS)
+    {
+        printf("Failed to invalidate mapped memory.\n");
+    }
+}
+
+VkBuffer vk_create_buffer_and_memory(
+    VkPhysicalDevice vk_phy_device, VkDevice vk_device, 
+    uint32_t size, VkBufferUsageFlags usage, vk_memory_placement placement, vk_mapped_memory* deviceMemory)
+{
+    return vk_create_shared_buffer_and_memory(vk_phy_device, vk_device, size, usage, placement, 0, NULL, deviceMemory);
+}
+
+VkBuffer vk_create_shared_buffer_and_memory(
+    VkPhysicalDevice vk_phy_device, VkDevice vk_device,
+    uint32_t size, VkBufferUsageFlags usage, vk_memory_placement placement,
+    uint32_t queue_family_count, const uint32_t* queue_families, vk_mapped_memory* deviceMemory)
+{
+    memset(deviceMemory, 0, sizeof(*deviceMemory));
+
+    VkBufferCreateInfo bufferInfo;
+    memset(&bufferInfo, 0, sizeof(bufferInfo));
+
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    bufferInfo.usage = usage;
+
+    // Concurrent sharing saves the ownership transfers, it is only allowed between distinct families
+    if (queue_family_count > 1 && queue_families[0] != queue_families[1])
+    {
+        bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bufferInfo.queueFamilyIndexCount = queue_family_count;
+        bufferInfo.pQueueFamilyIndices = queue_families;
+    }
+
+    VkBuffer buffer;
+    if (vkCreateBuffer(vk_device, &bufferInfo, NULL, &buffer) != VK_SUCCESS)
+    {
+        printf("Failed to create a buffer.\n");
+        return VK_NULL_HANDLE;
+    }
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(vk_device, buffer, &memoryRequirements);
+
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(vk_phy_device, &deviceProperties);
+
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(vk_phy_device, &memProperties);
+
+    const VkMemoryPropertyFlags device = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    const VkMemoryPropertyFlags visible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    const VkMemoryPropertyFlags coherent = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    const VkMemoryPropertyFlags cached = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+
+    // Candidate property flags, most preferred first; the last ones always exist for buffers
+    VkMemoryPropertyFlags candidates[4];
+    uint32_t candidate_count = 0;
+
+    switch (placement)
+    {
+    case MEMORY_PLACEMENT_HOST_CACHED:
+        candidates[candidate_count++] = cached | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        candidates[candidate_count++] = cached;
+        break;
+    case MEMORY_PLACEMENT_DEVICE:
+        // Shared memory on integrated GPUs is as fast as it gets and saves the staging copy,
+        // reading uncached VRAM through a BAR on discrete GPUs is not
+        if (deviceProperties.deviceType != VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+        {
+            candidates[candidate_count++] = device | coherent;
+        }
+        candidates[candidate_count++] = device;
+        break;
+    case MEMORY_PLACEMENT_DEVICE_MAPPED:
+        candidates[candidate_count++] = device | coherent;
+        candidates[candidate_count++] = device | visible;
+        break;
+    default:
+        break;
+    }
+    candidates[candidate_count++] = coherent;
+    candidates[candidate_count++] = visible;
+
+    VkMemoryAllocateInfo memAllocInfo;
+    memset(&memAllocInfo, 0, sizeof(memAllocInfo));
+
+    memAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    memAllocInfo.allocationSize = memoryRequirements.size;
+    memAllocInfo.memoryTypeIndex = find_preferred_memory_type(&memProperties, memoryRequirements.memoryTypeBits, candidates, candidate_count);
+    if (memAllocInfo.memoryTypeIndex == VK_MAX_MEMORY_TYPES)
+    {
+        printf("Failed to find memory type index.\n");
+        vkDestroyBuffer(vk_device, buffer, NULL);
+        return VK_NULL_HANDLE;
+    }
+
+    if (vkAllocateMemory(vk_device, &memAllocInfo, NULL, &deviceMemory->memory) != VK_SUCCESS)
+    {
+        printf("Failed to allocate memory for the buffer.\n");
+        vkDestroyBuffer(vk_device, buffer, NULL);
+        return VK_NULL_HANDLE;
+    }
+    deviceMemory->size = memoryRequirements.size;
+
+    if (vkBindBufferMemory(vk_device, buffer, deviceMemory->memory, 0) != VK_SUCCESS)
+    {
+        printf("Failed to bind buffer and memory.\n");
+    }
+
+    // Device-only memory is never mapped, address stays NULL
+    VkMemoryPropertyFlags flags = memProperties.memoryTypes[memAllocInfo.memoryTypeIndex].propertyFlags;
+    if ((flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) == 0)
+    {
+        return buffer;
+    }
+    if ((flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) == 0)
+    {
+        deviceMemory->atom_size = deviceProperties.limits.nonCoherentAtomSize;
+    }
+
+    // Map once, the pointer stays valid until the memory is freed
+    if (vkMapMemory(vk_device, deviceMemory->memory, 0, VK_WHOLE_SIZE, 0, &deviceMemory->address) != VK_SUCCESS)
+    {
+        printf("Failed to map buffer memory.\n");
+        vkDestroyBuffer(vk_device, buffer, NULL);
+        vkFreeMemory(vk_device, deviceMemory->memory, NULL);
+        memset(deviceMemory, 0, sizeof(*deviceMemory));
+        return VK_NULL_HANDLE;
+    }
+
+    return buffer;
+}
+
+void vk_destroy_buffer(VkDevice vk_device, VkBuffer vk_buffer, vk_mapped_memory* vk_buffer_memory)
+{
+    vkDestroyBuffer(vk_device, vk_buffer, NULL);
+    if (vk_buffer_memory->address != NULL)
+    {
+        vkUnmapMemory(vk_device, vk_buffer_memory->memory);
+    }
+    vkFreeMemory(vk_device, vk_buffer_memory->memory, NULL);
+
+    memset(vk_buffer_memory, 0, sizeof(*vk_buffer_memory));
+}
+
+void vk_destroy_buffers(VkDevice vk_device, 
+    VkBuffer vk_input_buffer, VkBuffer vk_output_buffer,
+    vk_mapped_memory* vk_input_buffer_memory, vk_mapped_memory* vk_output_buffer_memory)
+{
+    vk_destroy_buffer(vk_device, vk_input_buffer, vk_input_buffer_memory);
+    vk_destroy_buffer(vk_device, vk_output_buffer, vk_output_buffer_memory);
+}
+
+void vk_copy_to_input_buffer(VkDevice vk_device, void *data, uint32_t size, const vk_mapped_memory* vk_input_buffer_memory)
+{
+    memcpy(vk_input_buffer_memory->address, data, size);
+    vk_flush_mapped_memory(vk_device, vk_input_buffer_memory, 0, size);
+}
+
+void vk_copy_from_output_buffer(VkDevice vk_device, void *data, uint32_t size, const vk_mapped_memory* vk_output_buffer_memory)
+{
+    vk_invalidate_mapped_memory(vk_device, vk_output_buffer_memory, 0, size);
+    memcpy(data, vk_output_buffer_memory->address, size);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,192 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "vkrt/pipeline_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PIPELINE_CACHE_MAGIC 0x48435046u     // "FPCH"
+#define PIPELINE_CACHE_VERSION 1u
+
+// Written in front of the vkGetPipelineCacheData blob
+typedef struct pipeline_cache_file_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vendor_id;
+    uint32_t device_id;
+    uint32_t driver_version;
+    uint8_t cache_uuid[VK_UUID_SIZE];
+    uint64_t data_size;
+} pipeline_cache_file_header;
+
+static void get_file_header(VkPhysicalDevice vk_phy_device, pipeline_cache_file_header* header)
+{
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(vk_phy_device, &deviceProperties);
+
+    memset(header, 0, sizeof(*header));
+    header->magic = PIPELINE_CACHE_MAGIC;
+    header->version = PIPELINE_CACHE_VERSION;
+    header->vendor_id = deviceProperties.vendorID;
+    header->device_id = deviceProperties.deviceID;
+    header->driver_version = deviceProperties.driverVersion;
+    memcpy(header->cache_uuid, deviceProperties.pipelineCacheUUID, VK_UUID_SIZE);
+}
+
+// Checks the header the driver puts at the start of its own data (VkPipelineCacheHeaderVersionOne)
+static int is_valid_cache_data(const pipeline_cache_file_header* expected, const uint8_t* data, uint64_t size)
+{
+    if (size < 16 + VK_UUID_SIZE)
+    {
+        return 0;
+    }
+
+    uint32_t fields[4];
+    memcpy(fields, data, sizeof(fields));
+
+    return fields[0] >= 16 + VK_UUID_SIZE &&
+           fields[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+           fields[2] == expected->vendor_id &&
+           fields[3] == expected->device_id &&
+           memcmp(data + 16, expected->cache_uuid, VK_UUID_SIZE) == 0;
+}
+
+// Returns the cached blob for this device and driver, or NULL
+static uint8_t* load_cache_data(VkPhysicalDevice vk_phy_device, const char* filename, size_t* size)
+{
+    FILE* f = fopen(filename, "rb");
+    if (f == NULL)
+    {
+        return NULL;
+    }
+
+    pipeline_cache_file_header expected;
+    get_file_header(vk_phy_device, &expected);
+
+    pipeline_cache_file_header header;
+    uint8_t* data = NULL;
+
+    if (fread(&header, sizeof(header), 1, f) != 1 ||
+        header.magic != PIPELINE_CACHE_MAGIC ||
+        header.version != PIPELINE_CACHE_VERSION)
+    {
+        printf("Ignoring %s: not a pipeline cache.\n", filename);
+    }
+    else if (header.vendor_id != expected.vendor_id ||
+             header.device_id != expected.device_id ||
+             header.driver_version != expected.driver_version ||
+             memcmp(header.cache_uuid, expected.cache_uuid, VK_UUID_SIZE) != 0)
+    {
+        printf("Ignoring %s: written for another device or driver.\n", filename);
+    }
+    else if (header.data_size == 0 || header.data_size > ((uint64_t)1 << 30) ||
+             (data = (uint8_t*)malloc((size_t)header.data_size)) == NULL ||
+             fread(data, 1, (size_t)header.data_size, f) != header.data_size ||
+             !is_valid_cache_data(&expected, data, header.data_size))
+    {
+        printf("Ignoring %s: the cache data is truncated or corrupt.\n", filename);
+        free(data);
+        data = NULL;
+    }
+    else
+    {
+        *size = (size_t)header.data_size;
+    }
+
+    fclose(f);
+    return data;
+}
+
+VkPipelineCache vk_create_pipeline_cache(VkPhysicalDevice vk_phy_device, VkDevice vk_device, const char* filename, int* warm)
+{
+    size_t size = 0;
+    uint8_t* data = load_cache_data(vk_phy_device, filename, &size);
+
+    VkPipelineCacheCreateInfo createInfo;
+    memset(&createInfo, 0, sizeof(createInfo));
+
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = size;
+    createInfo.pInitialData = data;
+
+    VkPipelineCache vk_pipeline_cache = VK_NULL_HANDLE;
+    VkResult result = vkCreatePipelineCache(vk_device, &createInfo, NULL, &vk_pipeline_cache);
+    if (result != VK_SUCCESS && data != NULL)
+    {
+        // The driver still rejected the data, start from an empty cache
+        createInfo.initialDataSize = 0;
+        createInfo.pInitialData = NULL;
+        free(data);
+        data = NULL;
+        result = vkCreatePipelineCache(vk_device, &createInfo, NULL, &vk_pipeline_cache);
+    }
+    free(data);
+
+    if (result != VK_SUCCESS)
+    {
+        printf("Failed to create a pipeline cache.\n");
+        return VK_NULL_HANDLE;
+    }
+    if (warm != NULL)
+    {
+        *warm = createInfo.initialDataSize > 0;
+    }
+    return vk_pipeline_cache;
+}
+
+int vk_save_pipeline_cache(VkPhysicalDevice vk_phy_device, VkDevice vk_device, VkPipelineCache vk_pipeline_cache, const char* filename)
+{
+    size_t size = 0;
+    if (vkGetPipelineCacheData(vk_device, vk_pipeline_cache, &size, NULL) != VK_SUCCESS || size == 0)
+    {
+        printf("Failed to query the pipeline cache size.\n");
+        return -1;
+    }
+
+    uint8_t* data = (uint8_t*)malloc(size);
+    if (data == NULL || vkGetPipelineCacheData(vk_device, vk_pipeline_cache, &size, data) != VK_SUCCESS)
+    {
+        printf("Failed to read the pipeline cache.\n");
+        free(data);
+        return -1;
+    }
+
+    pipeline_cache_file_header header;
+    get_file_header(vk_phy_device, &header);
+    header.data_size = size;
+
+    // Write to a temporary file first so an interrupted save never leaves a torn cache behind
+    char tmp_filename[1024];
+    snprintf(tmp_filename, sizeof(tmp_filename), "%s.tmp", filename);
+
+    FILE* f = fopen(tmp_filename, "wb");
+    int ok = f != NULL &&
+             fwrite(&header, sizeof(header), 1, f) == 1 &&
+             fwrite(data, 1, size, f) == size;
+    if (f != NULL && fclose(f) != 0)
+    {
+        ok = 0;
+    }
+    free(data);
+
+    if (!ok)
+    {
+        printf("Failed to write %s.\n", tmp_filename);
+        remove(tmp_filename);
+        return -1;
+    }
+
+    remove(filename);
+    if (rename(tmp_filename, filename) != 0)
+    {
+        printf("Failed to write %s.\n", filename);
+        return -1;
+    }
+    return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
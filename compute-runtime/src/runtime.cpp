@@ -0,0 +1,512 @@
+#include "vkrt/runtime.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+namespace vkrt {
+
+Buffer::Buffer(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize size, VkBufferUsageFlags usage,
+               vk_memory_placement placement)
+    : device(device), bytes(size)
+{
+    // The C allocator takes 32-bit sizes
+    if (size == 0 || size > UINT32_MAX) {
+        throw std::runtime_error("buffer size out of range!");
+    }
+
+    buffer = vk_create_buffer_and_memory(physicalDevice, device, (uint32_t)size, usage, placement, &memory);
+    if (buffer == VK_NULL_HANDLE) {
+        throw std::runtime_error("failed to create buffer!");
+    }
+}
+
+Buffer& Buffer::operator=(Buffer&& other) noexcept {
+    if (this != &other) {
+        reset();
+        device = std::exchange(other.device, {});
+        buffer = std::exchange(other.buffer, {});
+        memory = std::exchange(other.memory, {});
+        bytes = std::exchange(other.bytes, {});
+    }
+    return *this;
+}
+
+void Buffer::reset() {
+    if (buffer != VK_NULL_HANDLE) {
+        vk_destroy_buffer(device, buffer, &memory);
+    }
+    buffer = VK_NULL_HANDLE;
+    memory = vk_mapped_memory{};
+    bytes = 0;
+}
+
+void Buffer::flush(VkDeviceSize offset, VkDeviceSize size) const {
+    vk_flush_mapped_memory(device, &memory, offset, size == VK_WHOLE_SIZE ? memory.size - offset : size);
+}
+
+void Buffer::invalidate(VkDeviceSize offset, VkDeviceSize size) const {
+    vk_invalidate_mapped_memory(device, &memory, offset, size == VK_WHOLE_SIZE ? memory.size - offset : size);
+}
+
+PipelineCache::PipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, const char* filename)
+    : physicalDevice(physicalDevice), device(device), filename(filename)
+{
+    int warm = 0;
+    cache = vk_create_pipeline_cache(physicalDevice, device, filename, &warm);
+    if (cache == VK_NULL_HANDLE) {
+        throw std::runtime_error("failed to create pipeline cache!");
+    }
+    wasWarm = warm != 0;
+}
+
+PipelineCache& PipelineCache::operator=(PipelineCache&& other) noexcept {
+    if (this != &other) {
+        reset();
+        physicalDevice = std::exchange(other.physicalDevice, {});
+        device = std::exchange(other.device, {});
+        cache = std::exchange(other.cache, {});
+        filename = std::move(other.filename);
+        wasWarm = std::exchange(other.wasWarm, {});
+    }
+    return *this;
+}
+
+void PipelineCache::reset() {
+    if (cache != VK_NULL_HANDLE) {
+        vkDestroyPipelineCache(device, cache, nullptr);
+    }
+    cache = VK_NULL_HANDLE;
+}
+
+bool PipelineCache::save() const {
+    return cache != VK_NULL_HANDLE && vk_save_pipeline_cache(physicalDevice, device, cache, filename.c_str()) == 0;
+}
+
+Kernel::Kernel(VkDevice device, const char* filename, uint32_t bindingCount, uint32_t pushConstantsSize,
+               VkPipelineCache cache, const VkSpecializationInfo* specialization)
+    : device(device), bindings(bindingCount), pushSize(pushConstantsSize)
+{
+    VkShaderModule shaderModule = vk_create_compute_shader(device, filename);
+    if (shaderModule == VK_NULL_HANDLE) {
+        throw std::runtime_error(std::string("failed to create shader module ") + filename + "!");
+    }
+
+    descriptorSetLayout = vk_create_storage_set_layout(device, bindingCount);
+    if (descriptorSetLayout != VK_NULL_HANDLE) {
+        pipelineLayout = vk_create_pipeline_layout(device, descriptorSetLayout, pushConstantsSize);
+    }
+    if (pipelineLayout != VK_NULL_HANDLE) {
+        computePipeline = vk_create_pipline(device, pipelineLayout, descriptorSetLayout, shaderModule, cache, specialization);
+    }
+
+    // The pipeline keeps what it needs from the module
+    vkDestroyShaderModule(device, shaderModule, nullptr);
+
+    if (computePipeline == VK_NULL_HANDLE) {
+        reset();
+        throw std::runtime_error(std::string("failed to create compute pipeline for ") + filename + "!");
+    }
+}
+
+Kernel& Kernel::operator=(Kernel&& other) noexcept {
+    if (this != &other) {
+        reset();
+        device = std::exchange(other.device, {});
+        descriptorSetLayout = std::exchange(other.descriptorSetLayout, {});
+        pipelineLayout = std::exchange(other.pipelineLayout, {});
+        computePipeline = std::exchange(other.computePipeline, {});
+        bindings = std::exchange(other.bindings, {});
+        pushSize = std::exchange(other.pushSize, {});
+    }
+    return *this;
+}
+
+void Kernel::reset() {
+    if (computePipeline != VK_NULL_HANDLE) {
+        vkDestroyPipeline(device, computePipeline, nullptr);
+    }
+    if (pipelineLayout != VK_NULL_HANDLE) {
+        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+    }
+    if (descriptorSetLayout != VK_NULL_HANDLE) {
+        vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+    }
+    computePipeline = VK_NULL_HANDLE;
+    pipelineLayout = VK_NULL_HANDLE;
+    descriptorSetLayout = VK_NULL_HANDLE;
+}
+
+void Kernel::bind(VkDescriptorSet set, const std::vector<VkDescriptorBufferInfo>& buffers) const {
+    if (buffers.size() != bindings) {
+        throw std::runtime_error("wrong number of buffers for the kernel's bindings!");
+    }
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = 0;
+    write.descriptorCount = bindings;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo = buffers.data();
+
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+}
+
+void Kernel::dispatch(VkCommandBuffer commandBuffer, VkDescriptorSet set, const void* pushConstants,
+                      uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) const {
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &set, 0, nullptr);
+    if (pushSize > 0) {
+        vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, pushSize, pushConstants);
+    }
+    vkCmdDispatch(commandBuffer, groupCountX, groupCountY, groupCountZ);
+}
+
+// Largest pool the allocator grows to, in sets
+const uint32_t MAX_SETS_PER_POOL = 4096;
+
+// Handles are pointers or 64-bit integers depending on the platform
+template <typename Handle>
+static uint64_t handle_key(Handle handle) {
+    uint64_t key = 0;
+    std::memcpy(&key, &handle, sizeof(handle));
+    return key;
+}
+
+DescriptorAllocator::DescriptorAllocator(VkDevice device, std::vector<VkDescriptorPoolSize> descriptorsPerSet,
+                                         uint32_t frameCount, uint32_t setsPerPool)
+    : device(device), descriptorsPerSet(std::move(descriptorsPerSet)), nextPoolSets(setsPerPool), frames(frameCount)
+{
+}
+
+DescriptorAllocator& DescriptorAllocator::operator=(DescriptorAllocator&& other) noexcept {
+    if (this != &other) {
+        reset();
+        device = std::exchange(other.device, {});
+        descriptorsPerSet = std::move(other.descriptorsPerSet);
+        nextPoolSets = std::exchange(other.nextPoolSets, {});
+        persistent = std::exchange(other.persistent, {});
+        frames = std::move(other.frames);
+        spare = std::move(other.spare);
+        cache = std::move(other.cache);
+    }
+    return *this;
+}
+
+void DescriptorAllocator::reset() {
+    auto destroy = [this](PoolList& pools) {
+        for (VkDescriptorPool pool : pools.full) {
+            vkDestroyDescriptorPool(device, pool, nullptr);
+        }
+        if (pools.current != VK_NULL_HANDLE) {
+            vkDestroyDescriptorPool(device, pools.current, nullptr);
+        }
+        pools = PoolList{};
+    };
+
+    destroy(persistent);
+    for (PoolList& pools : frames) {
+        destroy(pools);
+    }
+    for (VkDescriptorPool pool : spare) {
+        vkDestroyDescriptorPool(device, pool, nullptr);
+    }
+    spare.clear();
+    cache.clear();
+}
+
+VkDescriptorPool DescriptorAllocator::acquirePool() {
+    if (!spare.empty()) {
+        VkDescriptorPool pool = spare.back();
+        spare.pop_back();
+        return pool;
+    }
+
+    std::vector<VkDescriptorPoolSize> poolSizes = descriptorsPerSet;
+    for (VkDescriptorPoolSize& poolSize : poolSizes) {
+        poolSize.descriptorCount *= nextPoolSets;
+    }
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = nextPoolSets;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor pool!");
+    }
+
+    nextPoolSets = std::min(nextPoolSets * 2, MAX_SETS_PER_POOL);
+    return pool;
+}
+
+VkDescriptorSet DescriptorAllocator::allocate(PoolList& pools, VkDescriptorSetLayout layout) {
+    // A fresh pool always has room, so the second attempt only fails on real errors
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (pools.current == VK_NULL_HANDLE) {
+            pools.current = acquirePool();
+        }
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = pools.current;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &layout;
+
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        VkResult result = vkAllocateDescriptorSets(device, &allocInfo, &set);
+        if (result == VK_SUCCESS) {
+            return set;
+        }
+        if (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) {
+            break;
+        }
+
+        pools.full.push_back(pools.current);
+        pools.current = VK_NULL_HANDLE;
+    }
+    throw std::runtime_error("failed to allocate descriptor set!");
+}
+
+VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout) {
+    return allocate(persistent, layout);
+}
+
+VkDescriptorSet DescriptorAllocator::get(VkDescriptorSetLayout layout, const std::vector<BufferBinding>& bindings) {
+    std::vector<uint64_t> key;
+    key.reserve(1 + bindings.size() * 4);
+    key.push_back(handle_key(layout));
+    for (const BufferBinding& binding : bindings) {
+        key.push_back((uint64_t(binding.binding) << 32) | uint32_t(binding.type));
+        key.push_back(handle_key(binding.buffer.buffer));
+        key.push_back(binding.buffer.offset);
+        key.push_back(binding.buffer.range);
+    }
+
+    auto cached = cache.find(key);
+    if (cached != cache.end()) {
+        return cached->second;
+    }
+
+    VkDescriptorSet set = allocate(persistent, layout);
+
+    std::vector<VkWriteDescriptorSet> writes(bindings.size());
+    for (size_t i = 0; i < bindings.size(); i++) {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = set;
+        writes[i].dstBinding = bindings[i].binding;
+        writes[i].dstArrayElement = 0;
+        writes[i].descriptorType = bindings[i].type;
+        writes[i].descriptorCount = 1;
+        writes[i].pBufferInfo = &bindings[i].buffer;
+    }
+    vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+    cache.emplace(std::move(key), set);
+    return set;
+}
+
+void DescriptorAllocator::invalidate(VkBuffer buffer) {
+    // Keys are the layout, then binding and type, buffer, offset and range per binding
+    uint64_t bufferKey = handle_key(buffer);
+    for (auto it = cache.begin(); it != cache.end();) {
+        bool points = false;
+        for (size_t i = 2; i < it->first.size(); i += 4) {
+            points = points || it->first[i] == bufferKey;
+        }
+        it = points ? cache.erase(it) : std::next(it);
+    }
+}
+
+void DescriptorAllocator::beginFrame(uint32_t frame) {
+    PoolList& pools = frames.at(frame);
+    if (pools.current != VK_NULL_HANDLE) {
+        pools.full.push_back(pools.current);
+        pools.current = VK_NULL_HANDLE;
+    }
+
+    // Resetting frees every set of the pool at once
+    for (VkDescriptorPool pool : pools.full) {
+        vkResetDescriptorPool(device, pool, 0);
+        spare.push_back(pool);
+    }
+    pools.full.clear();
+}
+
+VkDescriptorSet DescriptorAllocator::allocateForFrame(uint32_t frame, VkDescriptorSetLayout layout) {
+    return allocate(frames.at(frame), layout);
+}
+
+size_t DescriptorAllocator::poolCount() const {
+    auto count = [](const PoolList& pools) {
+        return pools.full.size() + (pools.current != VK_NULL_HANDLE ? 1 : 0);
+    };
+
+    size_t total = count(persistent) + spare.size();
+    for (const PoolList& pools : frames) {
+        total += count(pools);
+    }
+    return total;
+}
+
+Fence::Fence(VkDevice device, bool signaled)
+    : device(device)
+{
+    VkFenceCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    createInfo.flags = signaled ? VK_FENCE_CREATE_SIGNALED_BIT : 0;
+
+    if (vkCreateFence(device, &createInfo, nullptr, &fence) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create fence!");
+    }
+}
+
+Fence& Fence::operator=(Fence&& other) noexcept {
+    if (this != &other) {
+        reset();
+        device = std::exchange(other.device, {});
+        fence = std::exchange(other.fence, {});
+    }
+    return *this;
+}
+
+void Fence::reset() {
+    if (fence != VK_NULL_HANDLE) {
+        vkDestroyFence(device, fence, nullptr);
+    }
+    fence = VK_NULL_HANDLE;
+}
+
+bool Fence::wait(uint64_t timeout) const {
+    VkResult result = vkWaitForFences(device, 1, &fence, VK_TRUE, timeout);
+    if (result != VK_SUCCESS && result != VK_TIMEOUT) {
+        throw std::runtime_error("failed to wait for fence!");
+    }
+    return result == VK_SUCCESS;
+}
+
+void Fence::unsignal() const {
+    vkResetFences(device, 1, &fence);
+}
+
+Semaphore::Semaphore(VkDevice device)
+    : device(device)
+{
+    semaphore = vk_create_semaphore(device);
+    if (semaphore == VK_NULL_HANDLE) {
+        throw std::runtime_error("failed to create semaphore!");
+    }
+}
+
+Semaphore& Semaphore::operator=(Semaphore&& other) noexcept {
+    if (this != &other) {
+        reset();
+        device = std::exchange(other.device, {});
+        semaphore = std::exchange(other.semaphore, {});
+    }
+    return *this;
+}
+
+void Semaphore::reset() {
+    if (semaphore != VK_NULL_HANDLE) {
+        vkDestroySemaphore(device, semaphore, nullptr);
+    }
+    semaphore = VK_NULL_HANDLE;
+}
+
+SubmitRing::SubmitRing(VkDevice device, uint32_t queueFamilyIndex)
+    : device(device)
+{
+    if (vk_create_submit_context(device, queueFamilyIndex, &ring) != 0) {
+        throw std::runtime_error("failed to create submit ring!");
+    }
+}
+
+SubmitRing& SubmitRing::operator=(SubmitRing&& other) noexcept {
+    if (this != &other) {
+        reset();
+        device = std::exchange(other.device, {});
+        ring = std::exchange(other.ring, {});
+    }
+    return *this;
+}
+
+void SubmitRing::reset() {
+    if (ring.command_pool != VK_NULL_HANDLE) {
+        vk_wait_submit_context(device, &ring);
+        vk_destroy_submit_context(device, &ring);
+    }
+    ring = vk_submit_context{};
+}
+
+VkCommandBuffer SubmitRing::begin() {
+    VkCommandBuffer commandBuffer = vk_begin_submit(device, &ring);
+    if (commandBuffer == VK_NULL_HANDLE) {
+        throw std::runtime_error("failed to begin command buffer!");
+    }
+    return commandBuffer;
+}
+
+void SubmitRing::submit(VkQueue queue, VkSemaphore wait, VkPipelineStageFlags waitStage, VkSemaphore signal) {
+    if (vk_end_submit_semaphores(device, queue, &ring, wait, waitStage, signal) != 0) {
+        throw std::runtime_error("failed to submit command buffer!");
+    }
+}
+
+void SubmitRing::wait() {
+    if (vk_wait_submit_context(device, &ring) != 0) {
+        throw std::runtime_error("failed to wait for submissions!");
+    }
+}
+
+Scheduler::Scheduler(VkDevice device, uint32_t queueFamilyIndex, uint32_t depth)
+    : device(device)
+{
+    if (vk_create_scheduler(device, queueFamilyIndex, depth, &scheduler) != 0) {
+        throw std::runtime_error("failed to create scheduler!");
+    }
+}
+
+Scheduler& Scheduler::operator=(Scheduler&& other) noexcept {
+    if (this != &other) {
+        reset();
+        device = std::exchange(other.device, {});
+        scheduler = std::exchange(other.scheduler, {});
+    }
+    return *this;
+}
+
+void Scheduler::reset() {
+    if (scheduler.timeline != VK_NULL_HANDLE) {
+        vk_destroy_scheduler(device, &scheduler);
+    }
+    scheduler = vk_scheduler{};
+}
+
+VkCommandBuffer Scheduler::begin() {
+    VkCommandBuffer commandBuffer = vk_scheduler_begin(device, &scheduler);
+    if (commandBuffer == VK_NULL_HANDLE) {
+        throw std::runtime_error("failed to begin command buffer!");
+    }
+    return commandBuffer;
+}
+
+uint64_t Scheduler::submit(VkQueue queue, const std::vector<vk_timeline_wait>& waits) {
+    uint64_t value = vk_scheduler_submit(queue, &scheduler, waits.data(), static_cast<uint32_t>(waits.size()));
+    if (value == 0) {
+        throw std::runtime_error("failed to submit command buffer!");
+    }
+    return value;
+}
+
+void Scheduler::wait(uint64_t value) const {
+    if (vk_scheduler_wait(device, &scheduler, value) != 0) {
+        throw std::runtime_error("failed to wait for timeline!");
+    }
+}
+
+}
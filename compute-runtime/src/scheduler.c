@@ -0,0 +1,254 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <string.h>
+#include <stdio.h>
+#include "vkrt/scheduler.h"
+#include "vkrt/compute.h"
+
+int vk_timeline_semaphores_supported(VkPhysicalDevice vk_phy_device)
+{
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(vk_phy_device, &deviceProperties);
+    if (deviceProperties.apiVersion < VK_API_VERSION_1_2)
+    {
+        return 0;
+    }
+
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures;
+    memset(&timelineFeatures, 0, sizeof(timelineFeatures));
+    timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+
+    VkPhysicalDeviceFeatures2 features2;
+    memset(&features2, 0, sizeof(features2));
+    features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features2.pNext = &timelineFeatures;
+    vkGetPhysicalDeviceFeatures2(vk_phy_device, &features2);
+
+    return timelineFeatures.timelineSemaphore == VK_TRUE;
+}
+
+VkSemaphore vk_create_timeline_semaphore(VkDevice vk_device, uint64_t initial_value)
+{
+    VkSemaphoreTypeCreateInfo typeCreateInfo;
+    memset(&typeCreateInfo, 0, sizeof(typeCreateInfo));
+    typeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeCreateInfo.initialValue = initial_value;
+
+    VkSemaphoreCreateInfo semaphoreCreateInfo;
+    memset(&semaphoreCreateInfo, 0, sizeof(semaphoreCreateInfo));
+    semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreCreateInfo.pNext = &typeCreateInfo;
+
+    VkSemaphore vk_semaphore = VK_NULL_HANDLE;
+    if (vkCreateSemaphore(vk_device, &semaphoreCreateInfo, NULL, &vk_semaphore) != VK_SUCCESS)
+    {
+        printf("Failed to create a timeline semaphore.\n");
+        return VK_NULL_HANDLE;
+    }
+    return vk_semaphore;
+}
+
+int vk_wait_timeline(VkDevice vk_device, VkSemaphore vk_timeline, uint64_t value, uint64_t timeout)
+{
+    VkSemaphoreWaitInfo waitInfo;
+    memset(&waitInfo, 0, sizeof(waitInfo));
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &vk_timeline;
+    waitInfo.pValues = &value;
+
+    return vkWaitSemaphores(vk_device, &waitInfo, timeout) == VK_SUCCESS ? 0 : -1;
+}
+
+int vk_signal_timeline(VkDevice vk_device, VkSemaphore vk_timeline, uint64_t value)
+{
+    VkSemaphoreSignalInfo signalInfo;
+    memset(&signalInfo, 0, sizeof(signalInfo));
+    signalInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO;
+    signalInfo.semaphore = vk_timeline;
+    signalInfo.value = value;
+
+    if (vkSignalSemaphore(vk_device, &signalInfo) != VK_SUCCESS)
+    {
+        printf("Failed to signal the timeline.\n");
+        return -1;
+    }
+    return 0;
+}
+
+uint64_t vk_timeline_value(VkDevice vk_device, VkSemaphore vk_timeline)
+{
+    uint64_t value = 0;
+    vkGetSemaphoreCounterValue(vk_device, vk_timeline, &value);
+    return value;
+}
+
+int vk_create_scheduler(VkDevice vk_device, uint32_t vk_queue_family_index, uint32_t depth, vk_scheduler* scheduler)
+{
+    memset(scheduler, 0, sizeof(*scheduler));
+    scheduler->depth = depth == 0 ? SUBMIT_RING_SIZE : depth;
+    if (scheduler->depth > SCHEDULER_MAX_DEPTH)
+    {
+        scheduler->depth = SCHEDULER_MAX_DEPTH;
+    }
+
+    scheduler->timeline = vk_create_timeline_semaphore(vk_device, 0);
+    if (scheduler->timeline == VK_NULL_HANDLE)
+    {
+        return -1;
+    }
+
+    // Command buffers are re-recorded in place instead of being freed
+    VkCommandPoolCreateInfo poolCreateInfo;
+    memset(&poolCreateInfo, 0, sizeof(poolCreateInfo));
+
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolCreateInfo.queueFamilyIndex = vk_queue_family_index;
+
+    if (vkCreateCommandPool(vk_device, &poolCreateInfo, NULL, &scheduler->command_pool) != VK_SUCCESS)
+    {
+        printf("Failed to create the scheduler command pool.\n");
+        vk_destroy_scheduler(vk_device, scheduler);
+        return -1;
+    }
+
+    VkCommandBufferAllocateInfo allocInfo;
+    memset(&allocInfo, 0, sizeof(allocInfo));
+
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = scheduler->command_pool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = scheduler->depth;
+
+    if (vkAllocateCommandBuffers(vk_device, &allocInfo, scheduler->command_buffers) != VK_SUCCESS)
+    {
+        printf("Failed to allocate the scheduler command buffers.\n");
+        vk_destroy_scheduler(vk_device, scheduler);
+        return -1;
+    }
+    return 0;
+}
+
+void vk_destroy_scheduler(VkDevice vk_device, vk_scheduler* scheduler)
+{
+    if (scheduler->timeline != VK_NULL_HANDLE)
+    {
+        vk_scheduler_wait_idle(vk_device, scheduler);
+        vkDestroySemaphore(vk_device, scheduler->timeline, NULL);
+    }
+    if (scheduler->command_pool != VK_NULL_HANDLE)
+    {
+        vkDestroyCommandPool(vk_device, scheduler->command_pool, NULL);
+    }
+    memset(scheduler, 0, sizeof(*scheduler));
+}
+
+VkCommandBuffer vk_scheduler_begin(VkDevice vk_device, vk_scheduler* scheduler)
+{
+    uint64_t value = scheduler->submitted + 1;
+
+    // The command buffer was last submitted depth values ago
+    if (value > scheduler->depth && vk_scheduler_wait(vk_device, scheduler, value - scheduler->depth) != 0)
+    {
+        return VK_NULL_HANDLE;
+    }
+
+    VkCommandBufferBeginInfo beginInfo;
+    memset(&beginInfo, 0, sizeof(beginInfo));
+
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    VkCommandBuffer vk_command_buffer = scheduler->command_buffers[value % scheduler->depth];
+    if (vkBeginCommandBuffer(vk_command_buffer, &beginInfo) != VK_SUCCESS)
+    {
+        printf("Failed to begin the buffer\n");
+        return VK_NULL_HANDLE;
+    }
+    return vk_command_buffer;
+}
+
+uint64_t vk_scheduler_submit(VkQueue vk_queue, vk_scheduler* scheduler, const vk_timeline_wait* waits, uint32_t wait_count)
+{
+    uint64_t value = scheduler->submitted + 1;
+    VkCommandBuffer vk_command_buffer = scheduler->command_buffers[value % scheduler->depth];
+
+    if (vkEndCommandBuffer(vk_command_buffer) != VK_SUCCESS)
+    {
+        printf("Failed to end the buffer\n");
+        return 0;
+    }
+
+    VkSemaphore wait_semaphores[SCHEDULER_MAX_DEPTH];
+    uint64_t wait_values[SCHEDULER_MAX_DEPTH];
+    VkPipelineStageFlags wait_stages[SCHEDULER_MAX_DEPTH];
+    if (wait_count > SCHEDULER_MAX_DEPTH)
+    {
+        printf("Too many timeline waits for one submission.\n");
+        return 0;
+    }
+    for (uint32_t i = 0; i < wait_count; i++)
+    {
+        wait_semaphores[i] = waits[i].timeline;
+        wait_values[i] = waits[i].value;
+        wait_stages[i] = waits[i].stage;
+    }
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo;
+    memset(&timelineInfo, 0, sizeof(timelineInfo));
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.waitSemaphoreValueCount = wait_count;
+    timelineInfo.pWaitSemaphoreValues = wait_values;
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &value;
+
+    VkSubmitInfo submitInfo;
+    memset(&submitInfo, 0, sizeof(submitInfo));
+
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.waitSemaphoreCount = wait_count;
+    submitInfo.pWaitSemaphores = wait_semaphores;
+    submitInfo.pWaitDstStageMask = wait_stages;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &vk_command_buffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &scheduler->timeline;
+
+    if (vkQueueSubmit(vk_queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+    {
+        printf("Submitting the command buffer failed\n");
+        return 0;
+    }
+
+    scheduler->submitted = value;
+    return value;
+}
+
+uint64_t vk_scheduler_completed(VkDevice vk_device, const vk_scheduler* scheduler)
+{
+    return vk_timeline_value(vk_device, scheduler->timeline);
+}
+
+int vk_scheduler_wait(VkDevice vk_device, const vk_scheduler* scheduler, uint64_t value)
+{
+    if (vk_wait_timeline(vk_device, scheduler->timeline, value, UINT64_MAX) != 0)
+    {
+        printf("Failed to wait for the timeline.\n");
+        return -1;
+    }
+    return 0;
+}
+
+int vk_scheduler_wait_idle(VkDevice vk_device, const vk_scheduler* scheduler)
+{
+    return vk_scheduler_wait(vk_device, scheduler, scheduler->submitted);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,156 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "vkrt/spirv.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const spirv_embedded_shader* embedded_shaders = NULL;
+static size_t embedded_shader_count = 0;
+
+void spirv_set_embedded_shaders(const spirv_embedded_shader* shaders, size_t count)
+{
+    embedded_shaders = shaders;
+    embedded_shader_count = count;
+}
+
+int spirv_validate(const char* name, const void* code, size_t size)
+{
+    if (size < SPIRV_HEADER_WORDS * sizeof(uint32_t) || size % sizeof(uint32_t) != 0)
+    {
+        printf("%s is not SPIR-V: %zu bytes is not a whole number of words.\n", name, size);
+        return -1;
+    }
+    if ((uintptr_t)code % sizeof(uint32_t) != 0)
+    {
+        printf("%s is not aligned to 4 bytes.\n", name);
+        return -1;
+    }
+
+    uint32_t magic = ((const uint32_t*)code)[0];
+    if (magic != SPIRV_MAGIC)
+    {
+        // Vulkan only takes SPIR-V in host byte order
+        const uint32_t swapped = 0x03022307u;
+        printf(magic == swapped ? "%s is SPIR-V in the wrong byte order.\n" : "%s is not SPIR-V: bad magic number.\n", name);
+        return -1;
+    }
+    return 0;
+}
+
+// Maps the whole file read-only, returns NULL if it can't be opened or is empty
+static void* map_file(const char* filename, size_t* size)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return NULL;
+    }
+
+    void* address = NULL;
+    LARGE_INTEGER file_size;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0)
+    {
+        // The view keeps the mapping alive once both handles are closed
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping != NULL)
+        {
+            address = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+        *size = (size_t)file_size.QuadPart;
+    }
+    CloseHandle(file);
+    return address;
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+
+    void* address = NULL;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        address = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED)
+        {
+            address = NULL;
+        }
+        *size = (size_t)st.st_size;
+    }
+    close(fd);
+    return address;
+#endif
+}
+
+static void unmap_file(void* address, size_t size)
+{
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(address);
+#else
+    munmap(address, size);
+#endif
+}
+
+int spirv_load(const char* filename, spirv_code* code)
+{
+    memset(code, 0, sizeof(*code));
+
+    for (size_t i = 0; i < embedded_shader_count; i++)
+    {
+        if (strcmp(embedded_shaders[i].filename, filename) == 0)
+        {
+            code->words = embedded_shaders[i].words;
+            code->size = embedded_shaders[i].size;
+            return spirv_validate(filename, code->words, code->size);
+        }
+    }
+
+    size_t size = 0;
+    void* address = map_file(filename, &size);
+    if (address == NULL)
+    {
+        printf("Failed to open the shader file %s.\n", filename);
+        return -1;
+    }
+
+    // Mappings are page aligned, so only the size and contents can be wrong
+    if (spirv_validate(filename, address, size) != 0)
+    {
+        unmap_file(address, size);
+        return -1;
+    }
+
+    code->words = (const uint32_t*)address;
+    code->size = size;
+    code->mapping = address;
+    return 0;
+}
+
+void spirv_free(spirv_code* code)
+{
+    if (code->mapping != NULL)
+    {
+        unmap_file(code->mapping, code->size);
+    }
+    memset(code, 0, sizeof(*code));
+}
+
+#ifdef __cplusplus
+}
+#endif
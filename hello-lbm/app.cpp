@@ -1,21 +1,15 @@
 #include "app.h"
 #include <fmt/core.h>
 
-std::vector<char> VulkanParticleApp::read_file(const std::string& filename) {
-    std::ifstream file(filename, std::ios::ate | std::ios::binary);
-
-    if (!file.is_open()) {
-        throw std::runtime_error("failed to open file!");
+std::vector<uint32_t> VulkanParticleApp::read_spirv(const std::string& filename) {
+    // spirv_load maps the file and checks the size and magic number, printing why it failed
+    spirv_code code;
+    if (spirv_load(filename.c_str(), &code) != 0) {
+        throw std::runtime_error("failed to load shader file " + filename + "!");
     }
 
-    size_t fileSize = (size_t)file.tellg();
-    std::vector<char> buffer(fileSize);
-
-    file.seekg(0);
-    file.read(buffer.data(), fileSize);
-
-    file.close();
-
+    std::vector<uint32_t> buffer(code.words, code.words + code.size / sizeof(uint32_t));
+    spirv_free(&code);
     return buffer;
 }
 
@@ -306,11 +300,11 @@ void VulkanParticleApp::vk_create_framebuffers() {
     }
 }
 
-VkShaderModule VulkanParticleApp::vk_create_shader_module(const std::vector<char>& code) {
+VkShaderModule VulkanParticleApp::vk_create_shader_module(const std::vector<uint32_t>& code) {
     VkShaderModuleCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = code.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+    createInfo.codeSize = code.size() * sizeof(uint32_t);
+    createInfo.pCode = code.data();
 
     VkShaderModule shaderModule;
     if (vkCreateShaderModule(vk_device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
@@ -320,9 +314,7 @@ VkShaderModule VulkanParticleApp::vk_create_shader_module(const std::vector<char
     return shaderModule;
 }
 
-void VulkanParticleApp::vk_create_lbm_shader_storage_buffers() {
-
-    /*---------------------- Initialise LBM vector state as SSB on GPU --------------------------------------*/
+void VulkanParticleApp::vk_upload_lbm_distributions() {
     float w[] = { 
         (4.0 / 9.0),
         (1.0 / 9.0),
@@ -337,75 +329,68 @@ void VulkanParticleApp::vk_create_lbm_shader_storage_buffers() {
 
     VkDeviceSize bufferSize = sizeof(float) * NX * NY * NUM_VECTORS;
 
-    float* temp = (float*)malloc(bufferSize);
-    for (int k = 0; k < NUM_VECTORS; k++)
-        for (int y = 0; y < NY; y++)
-            for (int x = 0; x < NX; x++)
-                temp[k + x * NUM_VECTORS + y * NX * NUM_VECTORS] = w[k];
-
     // Create a staging buffer used to upload data to the gpu
-    VkBuffer df0_Buffer;
-    VkDeviceMemory df0_BufferMemory;
+    VkBuffer df_Buffer;
+    VkDeviceMemory df_BufferMemory;
     vk_create_buffer(bufferSize, 
         VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 
-        df0_Buffer, 
-        df0_BufferMemory
+        df_Buffer, 
+        df_BufferMemory
     );
 
-    void* df0_data;
-    vkMapMemory(vk_device, df0_BufferMemory, 0, bufferSize, 0, &df0_data);
-    memcpy(df0_data, temp, (size_t)bufferSize);
-    vkUnmapMemory(vk_device, df0_BufferMemory);
+    void* df_data;
+    vkMapMemory(vk_device, df_BufferMemory, 0, bufferSize, 0, &df_data);
 
-    vk_df0_storage_buffers.resize(MAX_FRAMES_IN_FLIGHT);
-    vk_df0_storage_buffers_memory.resize(MAX_FRAMES_IN_FLIGHT);
+    float* temp = (float*)df_data;
+    for (int k = 0; k < NUM_VECTORS; k++)
+        for (int y = 0; y < NY; y++)
+            for (int x = 0; x < NX; x++)
+                temp[lbm_distribution_index(x + y * NX, k)] = w[k];
+    vkUnmapMemory(vk_device, df_BufferMemory);
 
     // Copy initial data to storage buffers
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        vk_create_buffer(bufferSize, 
-            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 
-            vk_df0_storage_buffers[i], 
-            vk_df0_storage_buffers_memory[i]
-        );
-        vk_copy_buffer(df0_Buffer, vk_df0_storage_buffers[i], bufferSize);
+        vk_copy_buffer(df_Buffer, vk_df0_storage_buffers[i], bufferSize);
+        if (vk_df1_storage_buffers[i] != VK_NULL_HANDLE) {
+            vk_copy_buffer(df_Buffer, vk_df1_storage_buffers[i], bufferSize);
+        }
     }
 
-    vkDestroyBuffer(vk_device, df0_Buffer, nullptr);
-    vkFreeMemory(vk_device, df0_BufferMemory, nullptr);
+    vkDestroyBuffer(vk_device, df_Buffer, nullptr);
+    vkFreeMemory(vk_device, df_BufferMemory, nullptr);
+}
 
-    // Create a staging buffer used to upload data to the gpu
-    VkBuffer df1_Buffer;
-    VkDeviceMemory df1_BufferMemory;
-    vk_create_buffer(bufferSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        df1_Buffer,
-        df1_BufferMemory
-    );
+void VulkanParticleApp::vk_create_lbm_shader_storage_buffers() {
 
-    void* df1_data;
-    vkMapMemory(vk_device, df1_BufferMemory, 0, bufferSize, 0, &df1_data);
-    memcpy(df1_data, temp, (size_t)bufferSize);
-    vkUnmapMemory(vk_device, df1_BufferMemory);
+    /*---------------------- Initialise LBM vector state as SSB on GPU --------------------------------------*/
+    VkDeviceSize bufferSize = sizeof(float) * NX * NY * NUM_VECTORS;
+
+    vk_df0_storage_buffers.resize(MAX_FRAMES_IN_FLIGHT);
+    vk_df0_storage_buffers_memory.resize(MAX_FRAMES_IN_FLIGHT);
 
-    vk_df1_storage_buffers.resize(MAX_FRAMES_IN_FLIGHT);
-    vk_df1_storage_buffers_memory.resize(MAX_FRAMES_IN_FLIGHT);
+    // In-place streaming keeps the distributions in df0 alone, df1 stays null
+    vk_df1_storage_buffers.assign(MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE);
+    vk_df1_storage_buffers_memory.assign(MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE);
 
-    // Copy initial data to storage buffers
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        vk_create_buffer(bufferSize,
-            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-            vk_df1_storage_buffers[i],
-            vk_df1_storage_buffers_memory[i]
+        vk_create_buffer(bufferSize, 
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 
+            vk_df0_storage_buffers[i], 
+            vk_df0_storage_buffers_memory[i]
         );
-        vk_copy_buffer(df1_Buffer, vk_df1_storage_buffers[i], bufferSize);
+        if (lbm_streaming == LbmStreaming::PingPong) {
+            vk_create_buffer(bufferSize,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                vk_df1_storage_buffers[i],
+                vk_df1_storage_buffers_memory[i]
+            );
+        }
     }
 
-    vkDestroyBuffer(vk_device, df1_Buffer, nullptr);
-    vkFreeMemory(vk_device, df1_BufferMemory, nullptr);
+    vk_upload_lbm_distributions();
 
     vk_dcf_storage_buffers.resize(MAX_FRAMES_IN_FLIGHT);
     vk_dcf_storage_buffers_memory.resize(MAX_FRAMES_IN_FLIGHT);
@@ -607,45 +592,6 @@ void VulkanParticleApp::vk_create_obstacle_vertex_buffer() {
     vkUnmapMemory(vk_device, vk_obstacle_vertex_buffer_memory);
 }
 
-void VulkanParticleApp::vk_create_lbm_descriptor_pool_0_1() {
-    std::array<VkDescriptorPoolSize, 2> poolSizes{};
-    poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    poolSizes[0].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-
-    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    poolSizes[1].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT) * 5;
-
-    VkDescriptorPoolCreateInfo poolInfo{};
-    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    poolInfo.poolSizeCount = 2;
-    poolInfo.pPoolSizes = poolSizes.data();
-    poolInfo.maxSets = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-
-    if (vkCreateDescriptorPool(vk_device, &poolInfo, nullptr, &vk_lbm_compute_descriptor_pool_0_1) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create descriptor pool!");
-    }
-}
-
-void VulkanParticleApp::vk_create_lbm_descriptor_pool_1_0() {
-    std::array<VkDescriptorPoolSize, 2> poolSizes{};
-    poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    poolSizes[0].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-
-    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    poolSizes[1].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT) * 5;
-
-    VkDescriptorPoolCreateInfo poolInfo{};
-    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    poolInfo.poolSizeCount = 2;
-    poolInfo.pPoolSizes = poolSizes.data();
-    poolInfo.maxSets = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-
-    if (vkCreateDescriptorPool(vk_device, &poolInfo, nullptr, &vk_lbm_compute_descriptor_pool_1_0) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create descriptor pool!");
-    }
-}
-
-
 void VulkanParticleApp::vk_create_particle_graphics_descriptor_pool() {
     std::array<VkDescriptorPoolSize, 1> poolSizes{};
     poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
@@ -681,219 +627,31 @@ void VulkanParticleApp::vk_create_particle_descriptor_pool() {
     }
 }
 
-void VulkanParticleApp::vk_create_lbm_compute_descriptor_sets_0_1() {
-    std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, vk_lbm_compute_descriptor_set_layout);
-
-    VkDescriptorSetAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocInfo.descriptorPool = vk_lbm_compute_descriptor_pool_0_1;
-    allocInfo.descriptorSetCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-    allocInfo.pSetLayouts = layouts.data();
-
-    vk_lbm_compute_descriptor_sets_0_1.clear();
-    vk_lbm_compute_descriptor_sets_0_1.resize(MAX_FRAMES_IN_FLIGHT);
-
-    if (vkAllocateDescriptorSets(vk_device, &allocInfo, vk_lbm_compute_descriptor_sets_0_1.data()) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate descriptor sets!");
-    }
-
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        std::array<VkWriteDescriptorSet, 6> descriptorWrites{};
-
-        VkDescriptorBufferInfo uniformBufferInfo{};
-        uniformBufferInfo.buffer = vk_lbm_uniform_buffers[i];
-        uniformBufferInfo.offset = 0;
-        uniformBufferInfo.range = sizeof(LBMUniformBufferObject);
-
-        descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[0].dstSet = vk_lbm_compute_descriptor_sets_0_1[i];
-        descriptorWrites[0].dstBinding = 0;
-        descriptorWrites[0].dstArrayElement = 0;
-        descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        descriptorWrites[0].descriptorCount = 1;
-        descriptorWrites[0].pBufferInfo = &uniformBufferInfo;
-
-        // DF0
-        VkDescriptorBufferInfo storageBufferInfoDF0{};
-        storageBufferInfoDF0.buffer = vk_df0_storage_buffers[i];
-        storageBufferInfoDF0.offset = 0;
-        storageBufferInfoDF0.range = sizeof(float) * NX * NY * NUM_VECTORS;
-
-        descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[1].dstSet = vk_lbm_compute_descriptor_sets_0_1[i];
-        descriptorWrites[1].dstBinding = 1;
-        descriptorWrites[1].dstArrayElement = 0;
-        descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        descriptorWrites[1].descriptorCount = 1;
-        descriptorWrites[1].pBufferInfo = &storageBufferInfoDF0;
-
-        // DF1
-        VkDescriptorBufferInfo storageBufferInfoDF1{};
-        storageBufferInfoDF1.buffer = vk_df1_storage_buffers[i];
-        storageBufferInfoDF1.offset = 0;
-        storageBufferInfoDF1.range = sizeof(float) * NX * NY * NUM_VECTORS;
-
-        descriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[2].dstSet = vk_lbm_compute_descriptor_sets_0_1[i];
-        descriptorWrites[2].dstBinding = 2;
-        descriptorWrites[2].dstArrayElement = 0;
-        descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        descriptorWrites[2].descriptorCount = 1;
-        descriptorWrites[2].pBufferInfo = &storageBufferInfoDF1;
-
-        // DCF
-        VkDescriptorBufferInfo storageBufferInfoDCF{};
-        storageBufferInfoDCF.buffer = vk_dcf_storage_buffers[i];
-        storageBufferInfoDCF.offset = 0;
-        storageBufferInfoDCF.range = sizeof(float) * NX * NY;
-
-        descriptorWrites[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[3].dstSet = vk_lbm_compute_descriptor_sets_0_1[i];
-        descriptorWrites[3].dstBinding = 3;
-        descriptorWrites[3].dstArrayElement = 0;
-        descriptorWrites[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        descriptorWrites[3].descriptorCount = 1;
-        descriptorWrites[3].pBufferInfo = &storageBufferInfoDCF;
-
-        // DCU
-        VkDescriptorBufferInfo storageBufferInfoDCU{};
-        storageBufferInfoDCU.buffer = vk_dcu_storage_buffers[i];
-        storageBufferInfoDCU.offset = 0;
-        storageBufferInfoDCU.range = sizeof(float) * NX * NY;
-
-        descriptorWrites[4].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[4].dstSet = vk_lbm_compute_descriptor_sets_0_1[i];
-        descriptorWrites[4].dstBinding = 4;
-        descriptorWrites[4].dstArrayElement = 0;
-        descriptorWrites[4].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        descriptorWrites[4].descriptorCount = 1;
-        descriptorWrites[4].pBufferInfo = &storageBufferInfoDCU;
-
-        // DCV
-        VkDescriptorBufferInfo storageBufferInfoDCV{};
-        storageBufferInfoDCV.buffer = vk_dcv_storage_buffers[i];
-        storageBufferInfoDCV.offset = 0;
-        storageBufferInfoDCV.range = sizeof(float) * NX * NY;
-
-        descriptorWrites[5].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[5].dstSet = vk_lbm_compute_descriptor_sets_0_1[i];
-        descriptorWrites[5].dstBinding = 5;
-        descriptorWrites[5].dstArrayElement = 0;
-        descriptorWrites[5].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        descriptorWrites[5].descriptorCount = 1;
-        descriptorWrites[5].pBufferInfo = &storageBufferInfoDCV;
-
-        vkUpdateDescriptorSets(vk_device, 6, descriptorWrites.data(), 0, nullptr);
-    }
-}
-
-void VulkanParticleApp::vk_create_lbm_compute_descriptor_sets_1_0() {
-    std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, vk_lbm_compute_descriptor_set_layout);
+VkDescriptorSet VulkanParticleApp::vk_lbm_compute_descriptor_set(uint32_t frame, bool swapped) {
+    const VkDeviceSize distributionSize = sizeof(float) * NX * NY * NUM_VECTORS;
+    const VkDeviceSize fieldSize = sizeof(float) * NX * NY;
 
-    VkDescriptorSetAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocInfo.descriptorPool = vk_lbm_compute_descriptor_pool_1_0;
-    allocInfo.descriptorSetCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-    allocInfo.pSetLayouts = layouts.data();
+    VkBuffer src = swapped ? vk_df1_storage_buffers[frame] : vk_df0_storage_buffers[frame];
+    VkBuffer dst = swapped ? vk_df0_storage_buffers[frame] : vk_df1_storage_buffers[frame];
 
-    vk_lbm_compute_descriptor_sets_1_0.clear();
-    vk_lbm_compute_descriptor_sets_1_0.resize(MAX_FRAMES_IN_FLIGHT);
-
-    if (vkAllocateDescriptorSets(vk_device, &allocInfo, vk_lbm_compute_descriptor_sets_1_0.data()) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate descriptor sets!");
+    // lbm_aa.comp never reads binding 2, df0 fills it so the set stays complete
+    if (lbm_streaming == LbmStreaming::InPlace) {
+        src = vk_df0_storage_buffers[frame];
+        dst = vk_df0_storage_buffers[frame];
     }
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        std::array<VkWriteDescriptorSet, 6> descriptorWrites{};
-
-        VkDescriptorBufferInfo uniformBufferInfo{};
-        uniformBufferInfo.buffer = vk_lbm_uniform_buffers[i];
-        uniformBufferInfo.offset = 0;
-        uniformBufferInfo.range = sizeof(LBMUniformBufferObject);
-
-        descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[0].dstSet = vk_lbm_compute_descriptor_sets_1_0[i];
-        descriptorWrites[0].dstBinding = 0;
-        descriptorWrites[0].dstArrayElement = 0;
-        descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        descriptorWrites[0].descriptorCount = 1;
-        descriptorWrites[0].pBufferInfo = &uniformBufferInfo;
-
-        // DF1
-        VkDescriptorBufferInfo storageBufferInfoDF1{};
-        storageBufferInfoDF1.buffer = vk_df1_storage_buffers[i];
-        storageBufferInfoDF1.offset = 0;
-        storageBufferInfoDF1.range = sizeof(float) * NX * NY * NUM_VECTORS;
-
-        descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[1].dstSet = vk_lbm_compute_descriptor_sets_1_0[i];
-        descriptorWrites[1].dstBinding = 1;
-        descriptorWrites[1].dstArrayElement = 0;
-        descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        descriptorWrites[1].descriptorCount = 1;
-        descriptorWrites[1].pBufferInfo = &storageBufferInfoDF1;
-
-        // DF0
-        VkDescriptorBufferInfo storageBufferInfoDF0{};
-        storageBufferInfoDF0.buffer = vk_df0_storage_buffers[i];
-        storageBufferInfoDF0.offset = 0;
-        storageBufferInfoDF0.range = sizeof(float) * NX * NY * NUM_VECTORS;
-
-        descriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[2].dstSet = vk_lbm_compute_descriptor_sets_1_0[i];
-        descriptorWrites[2].dstBinding = 2;
-        descriptorWrites[2].dstArrayElement = 0;
-        descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        descriptorWrites[2].descriptorCount = 1;
-        descriptorWrites[2].pBufferInfo = &storageBufferInfoDF0;
-
-        // DCF
-        VkDescriptorBufferInfo storageBufferInfoDCF{};
-        storageBufferInfoDCF.buffer = vk_dcf_storage_buffers[i];
-        storageBufferInfoDCF.offset = 0;
-        storageBufferInfoDCF.range = sizeof(float) * NX * NY;
-
-        descriptorWrites[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[3].dstSet = vk_lbm_compute_descriptor_sets_1_0[i];
-        descriptorWrites[3].dstBinding = 3;
-        descriptorWrites[3].dstArrayElement = 0;
-        descriptorWrites[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        descriptorWrites[3].descriptorCount = 1;
-        descriptorWrites[3].pBufferInfo = &storageBufferInfoDCF;
-
-        // DCU
-        VkDescriptorBufferInfo storageBufferInfoDCU{};
-        storageBufferInfoDCU.buffer = vk_dcu_storage_buffers[i];
-        storageBufferInfoDCU.offset = 0;
-        storageBufferInfoDCU.range = sizeof(float) * NX * NY;
-
-        descriptorWrites[4].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[4].dstSet = vk_lbm_compute_descriptor_sets_1_0[i];
-        descriptorWrites[4].dstBinding = 4;
-        descriptorWrites[4].dstArrayElement = 0;
-        descriptorWrites[4].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        descriptorWrites[4].descriptorCount = 1;
-        descriptorWrites[4].pBufferInfo = &storageBufferInfoDCU;
-
-        // DCV
-        VkDescriptorBufferInfo storageBufferInfoDCV{};
-        storageBufferInfoDCV.buffer = vk_dcv_storage_buffers[i];
-        storageBufferInfoDCV.offset = 0;
-        storageBufferInfoDCV.range = sizeof(float) * NX * NY;
-
-        descriptorWrites[5].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[5].dstSet = vk_lbm_compute_descriptor_sets_1_0[i];
-        descriptorWrites[5].dstBinding = 5;
-        descriptorWrites[5].dstArrayElement = 0;
-        descriptorWrites[5].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        descriptorWrites[5].descriptorCount = 1;
-        descriptorWrites[5].pBufferInfo = &storageBufferInfoDCV;
+    std::vector<vkrt::BufferBinding> bindings = {
+        { 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, { vk_lbm_uniform_buffers[frame], 0, sizeof(LBMUniformBufferObject) } },
+        { 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, { src, 0, distributionSize } },
+        { 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, { dst, 0, distributionSize } },
+        { 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, { vk_dcf_storage_buffers[frame], 0, fieldSize } },
+        { 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, { vk_dcu_storage_buffers[frame], 0, fieldSize } },
+        { 5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, { vk_dcv_storage_buffers[frame], 0, fieldSize } },
+    };
 
-        vkUpdateDescriptorSets(vk_device, 6, descriptorWrites.data(), 0, nullptr);
-    }
+    return vk_descriptor_allocator.get(vk_lbm_compute_descriptor_set_layout, bindings);
 }
 
-
 void VulkanParticleApp::vk_create_particle_compute_descriptor_sets() {
     std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, vk_particle_compute_descriptor_set_layout);
 
@@ -1200,8 +958,7 @@ void VulkanParticleApp::vk_cleanup() {
     vkDestroyPipeline(vk_device, vk_particle_compute_pipeline, nullptr);
     vkDestroyPipelineLayout(vk_device, vk_particle_compute_pipeline_layout, nullptr);
 
-    vkDestroyPipeline(vk_device, vk_lbm_compute_pipeline, nullptr);
-    vkDestroyPipelineLayout(vk_device, vk_lbm_compute_pipeline_layout, nullptr);
+    vk_destroy_lbm_compute_pipeline();
 
     vkDestroyRenderPass(vk_device, vk_render_pass, nullptr);
 
@@ -1213,8 +970,7 @@ void VulkanParticleApp::vk_cleanup() {
         vkFreeMemory(vk_device, vk_particle_uniform_buffers_memory[i], nullptr);
     }
 
-    vkDestroyDescriptorPool(vk_device, vk_lbm_compute_descriptor_pool_0_1, nullptr);
-    vkDestroyDescriptorPool(vk_device, vk_lbm_compute_descriptor_pool_1_0, nullptr);
+    vk_descriptor_allocator.reset();
 
     vkDestroyDescriptorPool(vk_device, vk_particle_compute_descriptor_pool, nullptr);
     vkDestroyDescriptorPool(vk_device, vk_particle_graphics_descriptor_pool, nullptr);
@@ -1264,6 +1020,9 @@ void VulkanParticleApp::vk_cleanup() {
 
     vkDestroyCommandPool(vk_device, vk_command_pool, nullptr);
 
+    vk_pipeline_cache.save();
+    vk_pipeline_cache.reset();
+
     vkDestroyDevice(vk_device, nullptr);
 
     if (vk_check_validation_layer_support()) {
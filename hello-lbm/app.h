@@ -23,6 +23,10 @@
 #include <set>
 #include <random>
 
+#include "vkrt/memory.h"
+#include "vkrt/runtime.hpp"
+#include "vkrt/spirv.h"
+
 extern int gWindowWidth;
 extern int gWindowHeight;
 
@@ -109,8 +113,23 @@ struct Particle {
     }
 };
 
+// How the LBM substeps stream the distributions
+enum class LbmStreaming {
+    PingPong,   // From df0 into df1 and back
+    InPlace,    // AA pattern in df0 alone, alternating even and odd kernels
+};
+
+// Order of the LBM distributions in df0 and df1
+enum class LbmLayout {
+    AoS,        // Nine directions of a cell together, f[cell * NUM_VECTORS + k]
+    SoA,        // One array per direction, f[k * NX * NY + cell]
+};
+
 class VulkanParticleApp {
 public:
+    LbmStreaming lbm_streaming = LbmStreaming::PingPong;
+    LbmLayout lbm_layout = LbmLayout::AoS;
+
     void run() {
         vk_init_window();
 
@@ -120,6 +139,9 @@ public:
         vk_cleanup();
     }
 
+    // Times the LBM substeps alone in both layouts and prints their MLUPS
+    void benchmark();
+
     void reset_particles();
 
 private:
@@ -128,7 +150,6 @@ private:
     float xMouse, yMouse;
     int num_obstacle = 0;
 
-    int c = 0;
     int F_cpu[NX * NY];
 
     std::vector<Particle> vertices;
@@ -156,6 +177,9 @@ private:
 
     VkRenderPass vk_render_pass;
 
+    // Loaded from and saved to PIPELINE_CACHE_FILE
+    vkrt::PipelineCache vk_pipeline_cache;
+
     VkPipeline vk_obstacle_graphics_pipeline;
     VkPipelineLayout vk_obstacle_graphics_pipeline_layout;
 
@@ -167,6 +191,8 @@ private:
     std::vector<VkDescriptorSet> vk_particle_graphics_descriptor_sets;
 
     VkPipeline vk_lbm_compute_pipeline;
+    // Odd kernel of in-place streaming, vk_lbm_compute_pipeline runs the even steps
+    VkPipeline vk_lbm_odd_compute_pipeline = VK_NULL_HANDLE;
     VkPipelineLayout vk_lbm_compute_pipeline_layout;
 
     VkPipeline vk_particle_compute_pipeline;
@@ -178,11 +204,8 @@ private:
 
     VkDescriptorSetLayout vk_lbm_compute_descriptor_set_layout;
 
-    VkDescriptorPool vk_lbm_compute_descriptor_pool_0_1;
-    std::vector<VkDescriptorSet> vk_lbm_compute_descriptor_sets_0_1;
-
-    VkDescriptorPool vk_lbm_compute_descriptor_pool_1_0;
-    std::vector<VkDescriptorSet> vk_lbm_compute_descriptor_sets_1_0;
+    // LBM sets are written on first use and reused every step after
+    vkrt::DescriptorAllocator vk_descriptor_allocator;
 
     VkCommandPool vk_command_pool;
 
@@ -277,6 +300,7 @@ private:
     void vk_create_particle_graphics_pipeline(const char* f_vert, const char* f_frag);
 
     void vk_create_lbm_compute_pipeline(const char* f_compute);
+    void vk_destroy_lbm_compute_pipeline();
 
     void vk_create_particle_compute_pipeline(const char* f_compute);
 
@@ -294,17 +318,12 @@ private:
 
 	void vk_create_particle_uniform_buffers();
 
-    void vk_create_lbm_descriptor_pool_0_1();
-
-    void vk_create_lbm_descriptor_pool_1_0();
-
 	void vk_create_particle_graphics_descriptor_pool();
 
     void vk_create_particle_descriptor_pool();
 
-    void vk_create_lbm_compute_descriptor_sets_0_1();
-  
-    void vk_create_lbm_compute_descriptor_sets_1_0();
+    // Set of a frame streaming df0 into df1, or df1 into df0 when swapped. In-place streaming binds df0 alone.
+    VkDescriptorSet vk_lbm_compute_descriptor_set(uint32_t frame, bool swapped);
 
     void vk_create_particle_compute_descriptor_sets();
 
@@ -325,7 +344,7 @@ private:
 
     void vk_create_particle_compute_command_buffers();
 
-    void vk_record_lbm_compute_command_buffer(VkCommandBuffer commandBuffer);
+    void vk_record_lbm_compute_command_buffer(VkCommandBuffer commandBuffer, uint32_t frame);
 
     void vk_record_particle_compute_command_buffer(VkCommandBuffer commandBuffer);
 
@@ -339,7 +358,7 @@ private:
 
     void vk_draw_frame();
 
-    VkShaderModule vk_create_shader_module(const std::vector<char>& code);
+    VkShaderModule vk_create_shader_module(const std::vector<uint32_t>& code);
 
     VkSurfaceFormatKHR vk_choose_swap_surface_format(const std::vector<VkSurfaceFormatKHR>& availableFormats);
 
@@ -359,7 +378,16 @@ private:
 
     bool vk_check_validation_layer_support();
 
-    std::vector<char> read_file(const std::string& filename);
+    // Loads a SPIR-V file through spirv_load, throws if it is missing or not SPIR-V
+    std::vector<uint32_t> read_spirv(const std::string& filename);
     void lbm_update_obstacle(void);
     void lbm_init_ssb(void);
+
+    // Writes a fluid at rest into df0 and df1 in the order of lbm_layout
+    void vk_upload_lbm_distributions();
+
+    // Position of direction k of a cell in df0 and df1, as fidx computes it in the LBM shaders
+    int lbm_distribution_index(int cell, int k) const {
+        return lbm_layout == LbmLayout::SoA ? k * NX * NY + cell : cell * NUM_VECTORS + k;
+    }
 };
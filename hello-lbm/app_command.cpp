@@ -39,6 +39,11 @@ void VulkanParticleApp::vk_create_lbm_compute_command_buffers() {
     if (vkAllocateCommandBuffers(vk_device, &allocInfo, vk_lbm_compute_command_buffers.data()) != VK_SUCCESS) {
         throw std::runtime_error("failed to allocate compute command buffers!");
     }
+
+    // The substeps bind the same buffers every frame, so their command buffers are recorded once and resubmitted
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        vk_record_lbm_compute_command_buffer(vk_lbm_compute_command_buffers[i], i);
+    }
 }
 
 void VulkanParticleApp::vk_create_particle_compute_command_buffers() {
@@ -129,7 +134,11 @@ void VulkanParticleApp::vk_record_graphics_command_buffer(VkCommandBuffer comman
 }
 
 
-void VulkanParticleApp::vk_record_lbm_compute_command_buffer(VkCommandBuffer commandBuffer) {
+// Every frame starts streaming from df0 with an even step, which only holds when the ping-pong,
+// or the alternation of in-place kernels, ends where it began
+static_assert(NUMR % 2 == 0, "NUMR must be even");
+
+void VulkanParticleApp::vk_record_lbm_compute_command_buffer(VkCommandBuffer commandBuffer, uint32_t frame) {
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
@@ -137,15 +146,48 @@ void VulkanParticleApp::vk_record_lbm_compute_command_buffer(VkCommandBuffer com
         throw std::runtime_error("failed to begin recording compute command buffer!");
     }
 
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, vk_lbm_compute_pipeline);
-
-    if(c == 0)
-        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, vk_lbm_compute_pipeline_layout, 0, 1, &vk_lbm_compute_descriptor_sets_0_1[currentFrame], 0, nullptr);
-    if (c == 1)
-		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, vk_lbm_compute_pipeline_layout, 0, 1, &vk_lbm_compute_descriptor_sets_1_0[currentFrame], 0, nullptr);
-    c = 1 - c;
+    bool inPlace = lbm_streaming == LbmStreaming::InPlace;
+    if (!inPlace) {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, vk_lbm_compute_pipeline);
+    }
 
-    vkCmdDispatch(commandBuffer, NX / 10, NY / 10, 1);
+    const VkDeviceSize distributionSize = sizeof(float) * NX * NY * NUM_VECTORS;
+    const VkDeviceSize fieldSize = sizeof(float) * NX * NY;
+
+    for (int step = 0; step < NUMR; step++) {
+        bool swapped = (step % 2) == 1;
+
+        // Each substep reads the distributions the previous one streamed and rewrites the velocity field.
+        // The first one is ordered after the last substep of the previous frame.
+        std::array<VkBufferMemoryBarrier, 3> barriers{};
+        VkBuffer written[] = {
+            swapped && !inPlace ? vk_df1_storage_buffers[frame] : vk_df0_storage_buffers[frame],
+            vk_dcu_storage_buffers[frame],
+            vk_dcv_storage_buffers[frame],
+        };
+        for (size_t i = 0; i < barriers.size(); i++) {
+            barriers[i].sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            barriers[i].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            barriers[i].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+            barriers[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barriers[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barriers[i].buffer = written[i];
+            barriers[i].offset = 0;
+            barriers[i].size = i == 0 ? distributionSize : fieldSize;
+        }
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+            0, nullptr, (uint32_t)barriers.size(), barriers.data(), 0, nullptr);
+
+        // In-place steps alternate between the even and odd kernels over df0
+        if (inPlace) {
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, swapped ? vk_lbm_odd_compute_pipeline : vk_lbm_compute_pipeline);
+        }
+
+        VkDescriptorSet lbmDescriptorSet = vk_lbm_compute_descriptor_set(frame, swapped);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, vk_lbm_compute_pipeline_layout, 0, 1, &lbmDescriptorSet, 0, nullptr);
+
+        vkCmdDispatch(commandBuffer, NX / 10, NY / 10, 1);
+    }
 
     if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
         throw std::runtime_error("failed to record LBM compute command buffer!");
@@ -1,8 +1,8 @@
 #include "app.h"
 
 void VulkanParticleApp::vk_create_obstacle_graphics_pipeline(const char* f_vert, const char* f_frag) {
-    auto vertShaderCode = read_file(f_vert);
-    auto fragShaderCode = read_file(f_frag);
+    auto vertShaderCode = read_spirv(f_vert);
+    auto fragShaderCode = read_spirv(f_frag);
 
     VkShaderModule vertShaderModule = vk_create_shader_module(vertShaderCode);
     VkShaderModule fragShaderModule = vk_create_shader_module(fragShaderCode);
@@ -112,7 +112,7 @@ void VulkanParticleApp::vk_create_obstacle_graphics_pipeline(const char* f_vert,
     pipelineInfo.subpass = 0;
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-    if (vkCreateGraphicsPipelines(vk_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &vk_obstacle_graphics_pipeline) != VK_SUCCESS) {
+    if (vkCreateGraphicsPipelines(vk_device, vk_pipeline_cache.handle(), 1, &pipelineInfo, nullptr, &vk_obstacle_graphics_pipeline) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create graphics pipeline!");
     }
 
@@ -121,8 +121,8 @@ void VulkanParticleApp::vk_create_obstacle_graphics_pipeline(const char* f_vert,
 }
 
 void VulkanParticleApp::vk_create_particle_graphics_pipeline(const char* f_vert, const char* f_frag) {
-    auto vertShaderCode = read_file(f_vert);
-    auto fragShaderCode = read_file(f_frag);
+    auto vertShaderCode = read_spirv(f_vert);
+    auto fragShaderCode = read_spirv(f_frag);
 
     VkShaderModule vertShaderModule = vk_create_shader_module(vertShaderCode);
     VkShaderModule fragShaderModule = vk_create_shader_module(fragShaderCode);
@@ -229,7 +229,7 @@ void VulkanParticleApp::vk_create_particle_graphics_pipeline(const char* f_vert,
     pipelineInfo.subpass = 0;
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-    if (vkCreateGraphicsPipelines(vk_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &vk_particle_graphics_pipeline) != VK_SUCCESS) {
+    if (vkCreateGraphicsPipelines(vk_device, vk_pipeline_cache.handle(), 1, &pipelineInfo, nullptr, &vk_particle_graphics_pipeline) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create graphics pipeline!");
     }
 
@@ -238,7 +238,7 @@ void VulkanParticleApp::vk_create_particle_graphics_pipeline(const char* f_vert,
 }
 
 void VulkanParticleApp::vk_create_lbm_compute_pipeline(const char* f_compute) {
-    auto computeShaderCode = read_file(f_compute);
+    auto computeShaderCode = read_spirv(f_compute);
 
     VkShaderModule computeShaderModule = vk_create_shader_module(computeShaderCode);
 
@@ -259,20 +259,53 @@ void VulkanParticleApp::vk_create_lbm_compute_pipeline(const char* f_compute) {
     computeShaderStageInfo.module = computeShaderModule;
     computeShaderStageInfo.pName = "main";
 
+    // Constant 0 picks the odd in-place kernel, constant 1 the SoA layout. lbm.comp only reads the layout.
+    std::array<VkBool32, 2> constants = { VK_FALSE, lbm_layout == LbmLayout::SoA ? VK_TRUE : VK_FALSE };
+    std::array<VkSpecializationMapEntry, 2> mapEntries = { {
+        { 0, 0, sizeof(VkBool32) },
+        { 1, sizeof(VkBool32), sizeof(VkBool32) },
+    } };
+
+    VkSpecializationInfo specializationInfo{};
+    specializationInfo.mapEntryCount = static_cast<uint32_t>(mapEntries.size());
+    specializationInfo.pMapEntries = mapEntries.data();
+    specializationInfo.dataSize = sizeof(constants);
+    specializationInfo.pData = constants.data();
+    computeShaderStageInfo.pSpecializationInfo = &specializationInfo;
+
     VkComputePipelineCreateInfo pipelineInfo{};
     pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
     pipelineInfo.layout = vk_lbm_compute_pipeline_layout;
     pipelineInfo.stage = computeShaderStageInfo;
 
-    if (vkCreateComputePipelines(vk_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &vk_lbm_compute_pipeline) != VK_SUCCESS) {
+    if (vkCreateComputePipelines(vk_device, vk_pipeline_cache.handle(), 1, &pipelineInfo, nullptr, &vk_lbm_compute_pipeline) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create LBM compute pipeline!");
     }
 
+    // In-place streaming specializes the same shader into its odd kernel
+    if (lbm_streaming == LbmStreaming::InPlace) {
+        constants[0] = VK_TRUE;
+
+        if (vkCreateComputePipelines(vk_device, vk_pipeline_cache.handle(), 1, &pipelineInfo, nullptr, &vk_lbm_odd_compute_pipeline) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create LBM odd step compute pipeline!");
+        }
+    }
+
     vkDestroyShaderModule(vk_device, computeShaderModule, nullptr);
 }
 
+void VulkanParticleApp::vk_destroy_lbm_compute_pipeline() {
+    vkDestroyPipeline(vk_device, vk_lbm_compute_pipeline, nullptr);
+    vkDestroyPipeline(vk_device, vk_lbm_odd_compute_pipeline, nullptr);
+    vkDestroyPipelineLayout(vk_device, vk_lbm_compute_pipeline_layout, nullptr);
+
+    vk_lbm_compute_pipeline = VK_NULL_HANDLE;
+    vk_lbm_odd_compute_pipeline = VK_NULL_HANDLE;
+    vk_lbm_compute_pipeline_layout = VK_NULL_HANDLE;
+}
+
 void VulkanParticleApp::vk_create_particle_compute_pipeline(const char* f_compute) {
-    auto computeShaderCode = read_file(f_compute);
+    auto computeShaderCode = read_spirv(f_compute);
 
     VkShaderModule computeShaderModule = vk_create_shader_module(computeShaderCode);
 
@@ -298,7 +331,7 @@ void VulkanParticleApp::vk_create_particle_compute_pipeline(const char* f_comput
     pipelineInfo.layout = vk_particle_compute_pipeline_layout;
     pipelineInfo.stage = computeShaderStageInfo;
 
-    if (vkCreateComputePipelines(vk_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &vk_particle_compute_pipeline) != VK_SUCCESS) {
+    if (vkCreateComputePipelines(vk_device, vk_pipeline_cache.handle(), 1, &pipelineInfo, nullptr, &vk_particle_compute_pipeline) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create particle compute pipeline!");
     }
 
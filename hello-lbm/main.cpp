@@ -75,6 +75,11 @@ void VulkanParticleApp::vk_init_window() {
     glfwSetCursorPos(gWindow, gWindowWidth / 2.0, gWindowHeight / 2.0);
 }
 
+// SPIR-V of the LBM kernel for a streaming mode
+static const char* lbm_shader_file(LbmStreaming streaming) {
+    return streaming == LbmStreaming::InPlace ? "shader/lbm_aa.spv" : "shader/lbm.spv";
+}
+
 void VulkanParticleApp::vk_init() {
     vk_create_instance();
 
@@ -93,12 +98,19 @@ void VulkanParticleApp::vk_init() {
 
     vk_create_particle_graphics_descriptor_set_layout();
 
+    // Warm launches reuse the pipelines compiled by the previous one
+    vk_pipeline_cache = vkrt::PipelineCache(vk_physical_device, vk_device, PIPELINE_CACHE_FILE);
+    auto pipelineStart = std::chrono::steady_clock::now();
+
     vk_create_obstacle_graphics_pipeline("shader/vert.spv", "shader/frag.spv");
     vk_create_particle_graphics_pipeline("shader/vert_particle.spv", "shader/frag_particle.spv");
 
-    vk_create_lbm_compute_pipeline("shader/lbm.spv");
+    vk_create_lbm_compute_pipeline(lbm_shader_file(lbm_streaming));
     vk_create_particle_compute_pipeline("shader/particles.spv");
 
+    auto pipelineTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - pipelineStart).count();
+    fmt::println("Pipeline creation: {:.3f} ms ({} cache)", pipelineTime, vk_pipeline_cache.warm() ? "warm" : "cold");
+
     vk_create_framebuffers();
     vk_create_command_pool();
     
@@ -110,15 +122,14 @@ void VulkanParticleApp::vk_init() {
     vk_create_lbm_uniform_buffers();
     vk_create_particle_uniform_buffers();
 
-    vk_create_lbm_descriptor_pool_0_1();
-    vk_create_lbm_descriptor_pool_1_0();
+    vk_descriptor_allocator = vkrt::DescriptorAllocator(vk_device, {
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 5 },
+    });
 
     vk_create_particle_descriptor_pool();
     vk_create_particle_graphics_descriptor_pool();
 
-    vk_create_lbm_compute_descriptor_sets_0_1();
-    vk_create_lbm_compute_descriptor_sets_1_0();
-
     vk_create_particle_compute_descriptor_sets();
     vk_create_particle_graphics_descriptor_sets();
 
@@ -144,16 +155,12 @@ void VulkanParticleApp::vk_draw_frame() {
 
     VkSubmitInfo submitInfo{};
 
-    // LBM Compute submission   
-    // TODO: Implement NUMR  
+    // LBM Compute submission: all NUMR substeps are in one prebuilt command buffer, ordered by barriers
     vkWaitForFences(vk_device, 1, &vk_lbm_compute_in_flight_fences[currentFrame], VK_TRUE, UINT64_MAX);
     vkResetFences(vk_device, 1, &vk_lbm_compute_in_flight_fences[currentFrame]);
 
     vk_update_lbm_uniform_buffer(currentFrame);
 
-    vkResetCommandBuffer(vk_lbm_compute_command_buffers[currentFrame], 0);
-    vk_record_lbm_compute_command_buffer(vk_lbm_compute_command_buffers[currentFrame]);
-
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
     submitInfo.commandBufferCount = 1;
@@ -164,37 +171,6 @@ void VulkanParticleApp::vk_draw_frame() {
     if (vkQueueSubmit(vk_compute_queue, 1, &submitInfo, vk_lbm_compute_in_flight_fences[currentFrame]) != VK_SUCCESS) {
         throw std::runtime_error("failed to submit compute command buffer!");
     };
-    vkQueueWaitIdle(vk_compute_queue);
-
-    for (int i = 0; i < (NUMR - 1); i++)
-    {
-        vkWaitForFences(vk_device, 1, &vk_lbm_compute_in_flight_fences[currentFrame], VK_TRUE, UINT64_MAX);
-        vkResetFences(vk_device, 1, &vk_lbm_compute_in_flight_fences[currentFrame]);
-
-        vk_update_lbm_uniform_buffer(currentFrame);
-
-        vkResetCommandBuffer(vk_lbm_compute_command_buffers[currentFrame], 0);
-        vk_record_lbm_compute_command_buffer(vk_lbm_compute_command_buffers[currentFrame]);
-
-        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-        VkSemaphore waitSemaphores[] = { vk_lbm_compute_finished_semaphores[currentFrame] };
-        VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT };
-
-        submitInfo.waitSemaphoreCount = 1;
-        submitInfo.pWaitSemaphores = waitSemaphores;
-        submitInfo.pWaitDstStageMask = waitStages;
-
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &vk_lbm_compute_command_buffers[currentFrame];
-        submitInfo.signalSemaphoreCount = 1;
-        submitInfo.pSignalSemaphores = &vk_lbm_compute_finished_semaphores[currentFrame];
-
-        if (vkQueueSubmit(vk_compute_queue, 1, &submitInfo, vk_lbm_compute_in_flight_fences[currentFrame]) != VK_SUCCESS) {
-            throw std::runtime_error("failed to submit compute command buffer!");
-        };
-        vkQueueWaitIdle(vk_compute_queue);
-    }
 
     // Particle Compute submission
     vkWaitForFences(vk_device, 1, &vk_particle_compute_in_flight_fences[currentFrame], VK_TRUE, UINT64_MAX);
@@ -308,9 +284,87 @@ void VulkanParticleApp::vk_main_loop() {
     vkDeviceWaitIdle(vk_device);
 };
 
-int main() {
+void VulkanParticleApp::benchmark() {
+    vk_init_window();
+    vk_init();
+
+    const int warmupFrames = 10;
+    const int timedFrames = 100;
+    const double updates = double(NX) * NY * NUMR * timedFrames;
+
+    double mlups[2] = {};
+    const LbmLayout layouts[2] = { LbmLayout::AoS, LbmLayout::SoA };
+    for (int l = 0; l < 2; l++) {
+        // Each layout starts from a fluid at rest, with its own pipelines and recorded substeps
+        vkDeviceWaitIdle(vk_device);
+        lbm_layout = layouts[l];
+        vk_destroy_lbm_compute_pipeline();
+        vk_create_lbm_compute_pipeline(lbm_shader_file(lbm_streaming));
+        vk_upload_lbm_distributions();
+        for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+            vkResetCommandBuffer(vk_lbm_compute_command_buffers[i], 0);
+            vk_record_lbm_compute_command_buffer(vk_lbm_compute_command_buffers[i], i);
+        }
+        vk_update_lbm_uniform_buffer(currentFrame);
+
+        // Nothing waits on the LBM semaphore here, so the submissions only signal the fence
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &vk_lbm_compute_command_buffers[currentFrame];
+
+        std::chrono::steady_clock::time_point start;
+        for (int frame = 0; frame < warmupFrames + timedFrames; frame++) {
+            if (frame == warmupFrames) {
+                start = std::chrono::steady_clock::now();
+            }
+            vkResetFences(vk_device, 1, &vk_lbm_compute_in_flight_fences[currentFrame]);
+            if (vkQueueSubmit(vk_compute_queue, 1, &submitInfo, vk_lbm_compute_in_flight_fences[currentFrame]) != VK_SUCCESS) {
+                throw std::runtime_error("failed to submit compute command buffer!");
+            }
+            vkWaitForFences(vk_device, 1, &vk_lbm_compute_in_flight_fences[currentFrame], VK_TRUE, UINT64_MAX);
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        mlups[l] = updates / seconds / 1e6;
+        fmt::println("{} layout: {:.1f} MLUPS ({} substeps in {:.3f} ms)", layouts[l] == LbmLayout::SoA ? "SoA" : "AoS",
+            mlups[l], NUMR * timedFrames, seconds * 1000.0);
+    }
+    fmt::println("SoA / AoS: {:.2f}x", mlups[1] / mlups[0]);
+
+    vkDeviceWaitIdle(vk_device);
+    vk_cleanup();
+}
+
+// Usage: hello-lbm [--in-place] [--soa] [--benchmark]
+//   --in-place    stream the distributions in place with the AA pattern, in one buffer instead of two
+//   --soa         store the distributions as one array per direction instead of nine floats per cell
+//   --benchmark   print the MLUPS of the LBM substeps in both layouts instead of running the simulation
+int main(int argc, char* argv[]) {
+    bool runBenchmark = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--in-place") == 0) {
+            app.lbm_streaming = LbmStreaming::InPlace;
+        }
+        else if (strcmp(argv[i], "--soa") == 0) {
+            app.lbm_layout = LbmLayout::SoA;
+        }
+        else if (strcmp(argv[i], "--benchmark") == 0) {
+            runBenchmark = true;
+        }
+        else {
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
     try {
-        app.run();
+        if (runBenchmark) {
+            app.benchmark();
+        }
+        else {
+            app.run();
+        }
     }
     catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
@@ -1,20 +1,14 @@
 #include "app.h"
 
-std::vector<char> VulkanParticleApp::read_file(const std::string& filename) {
-    std::ifstream file(filename, std::ios::ate | std::ios::binary);
-
-    if (!file.is_open()) {
-        throw std::runtime_error("failed to open file!");
+std::vector<uint32_t> VulkanParticleApp::read_spirv(const std::string& filename) {
+    // spirv_load maps the file and checks the size and magic number, printing why it failed
+    spirv_code code;
+    if (spirv_load(filename.c_str(), &code) != 0) {
+        throw std::runtime_error("failed to load shader file " + filename + "!");
     }
 
-    size_t fileSize = (size_t)file.tellg();
-    std::vector<char> buffer(fileSize);
-
-    file.seekg(0);
-    file.read(buffer.data(), fileSize);
-
-    file.close();
-
+    std::vector<uint32_t> buffer(code.words, code.words + code.size / sizeof(uint32_t));
+    spirv_free(&code);
     return buffer;
 }
 
@@ -83,11 +77,11 @@ void VulkanParticleApp::vk_create_framebuffers() {
     }
 }
 
-VkShaderModule VulkanParticleApp::vk_create_shader_module(const std::vector<char>& code) {
+VkShaderModule VulkanParticleApp::vk_create_shader_module(const std::vector<uint32_t>& code) {
     VkShaderModuleCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = code.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+    createInfo.codeSize = code.size() * sizeof(uint32_t);
+    createInfo.pCode = code.data();
 
     VkShaderModule shaderModule;
     if (vkCreateShaderModule(vk_device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
@@ -331,6 +325,9 @@ void VulkanParticleApp::vk_cleanup() {
 
     vkDestroyCommandPool(vk_device, vk_command_pool, nullptr);
 
+    vk_pipeline_cache.save();
+    vk_pipeline_cache.reset();
+
     vkDestroyDevice(vk_device, nullptr);
 
     if (vk_check_validation_layer_support()) {
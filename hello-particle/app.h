@@ -23,6 +23,10 @@
 #include <set>
 #include <random>
 
+#include "vkrt/memory.h"
+#include "vkrt/runtime.hpp"
+#include "vkrt/spirv.h"
+
 
 const uint32_t WIDTH = 800;
 const uint32_t HEIGHT = 600;
@@ -129,6 +133,9 @@ private:
 
     VkRenderPass vk_render_pass;
 
+    // Loaded from and saved to PIPELINE_CACHE_FILE
+    vkrt::PipelineCache vk_pipeline_cache;
+
     VkPipeline vk_graphics_pipeline;
     VkPipelineLayout vk_pipeline_layout;
 
@@ -233,7 +240,7 @@ private:
 
     void vk_draw_frame();
 
-    VkShaderModule vk_create_shader_module(const std::vector<char>& code);
+    VkShaderModule vk_create_shader_module(const std::vector<uint32_t>& code);
 
     VkSurfaceFormatKHR vk_choose_swap_surface_format(const std::vector<VkSurfaceFormatKHR>& availableFormats);
 
@@ -253,5 +260,6 @@ private:
 
     bool vk_check_validation_layer_support();
 
-    std::vector<char> read_file(const std::string& filename);
+    // Loads a SPIR-V file through spirv_load, throws if it is missing or not SPIR-V
+    std::vector<uint32_t> read_spirv(const std::string& filename);
 };
@@ -60,14 +60,9 @@ void VulkanParticleApp::vk_copy_buffer(VkBuffer srcBuffer, VkBuffer dstBuffer, V
 }
 
 uint32_t VulkanParticleApp::vk_find_memory_type(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
-    VkPhysicalDeviceMemoryProperties memProperties;
-    vkGetPhysicalDeviceMemoryProperties(vk_physical_device, &memProperties);
-
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-        if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-            return i;
-        }
+    uint32_t index = ::vk_find_memory_type(vk_physical_device, typeFilter, properties);
+    if (index == VK_MAX_MEMORY_TYPES) {
+        throw std::runtime_error("failed to find suitable memory type!");
     }
-
-    throw std::runtime_error("failed to find suitable memory type!");
+    return index;
 }
@@ -1,8 +1,8 @@
 #include "app.h"
 
 void VulkanParticleApp::vk_create_graphics_pipeline(const char* f_vert, const char* f_frag) {
-    auto vertShaderCode = read_file(f_vert);
-    auto fragShaderCode = read_file(f_frag);
+    auto vertShaderCode = read_spirv(f_vert);
+    auto fragShaderCode = read_spirv(f_frag);
 
     VkShaderModule vertShaderModule = vk_create_shader_module(vertShaderCode);
     VkShaderModule fragShaderModule = vk_create_shader_module(fragShaderCode);
@@ -112,7 +112,7 @@ void VulkanParticleApp::vk_create_graphics_pipeline(const char* f_vert, const ch
     pipelineInfo.subpass = 0;
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-    if (vkCreateGraphicsPipelines(vk_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &vk_graphics_pipeline) != VK_SUCCESS) {
+    if (vkCreateGraphicsPipelines(vk_device, vk_pipeline_cache.handle(), 1, &pipelineInfo, nullptr, &vk_graphics_pipeline) != VK_SUCCESS) {
         throw std::runtime_error("failed to create graphics pipeline!");
     }
 
@@ -121,7 +121,7 @@ void VulkanParticleApp::vk_create_graphics_pipeline(const char* f_vert, const ch
 }
 
 void VulkanParticleApp::vk_create_compute_pipeline(const char* f_compute) {
-    auto computeShaderCode = read_file(f_compute);
+    auto computeShaderCode = read_spirv(f_compute);
 
     VkShaderModule computeShaderModule = vk_create_shader_module(computeShaderCode);
 
@@ -145,7 +145,7 @@ void VulkanParticleApp::vk_create_compute_pipeline(const char* f_compute) {
     pipelineInfo.layout = vk_compute_pipeline_layout;
     pipelineInfo.stage = computeShaderStageInfo;
 
-    if (vkCreateComputePipelines(vk_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &vk_compute_pipeline) != VK_SUCCESS) {
+    if (vkCreateComputePipelines(vk_device, vk_pipeline_cache.handle(), 1, &pipelineInfo, nullptr, &vk_compute_pipeline) != VK_SUCCESS) {
         throw std::runtime_error("failed to create compute pipeline!");
     }
 
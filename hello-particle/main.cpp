@@ -1,3 +1,4 @@
+#include <fmt/core.h>
 #include "app.h"
 
 // Press ESC to close the window
@@ -56,9 +57,16 @@ void VulkanParticleApp::vk_init() {
 
     vk_create_compute_descriptor_set_layout();
 
+    // Warm launches reuse the pipelines compiled by the previous one
+    vk_pipeline_cache = vkrt::PipelineCache(vk_physical_device, vk_device, PIPELINE_CACHE_FILE);
+    auto pipelineStart = std::chrono::steady_clock::now();
+
     vk_create_graphics_pipeline("shader/vert.spv", "shader/frag.spv");
     vk_create_compute_pipeline("shader/comp.spv");
 
+    auto pipelineTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - pipelineStart).count();
+    fmt::println("Pipeline creation: {:.3f} ms ({} cache)", pipelineTime, vk_pipeline_cache.warm() ? "warm" : "cold");
+
     vk_create_framebuffers();
     vk_create_command_pool();
 
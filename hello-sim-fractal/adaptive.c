@@ -0,0 +1,143 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "adaptive.h"
+#include "vkrt/compute.h"
+#include <stdio.h>
+#include <string.h>
+
+static uint32_t blocks_across(uint32_t pixels)
+{
+    return (pixels + ADAPTIVE_BLOCK_SIZE - 1) / ADAPTIVE_BLOCK_SIZE;
+}
+
+uint32_t vk_adaptive_block_count(const vk_tile_plan* plan)
+{
+    return blocks_across(plan->tile_width) * blocks_across(plan->tile_height);
+}
+
+VkDeviceSize vk_adaptive_work_size(const vk_tile_plan* plan)
+{
+    return sizeof(VkDispatchIndirectCommand) + (VkDeviceSize)vk_adaptive_block_count(plan) * sizeof(uint32_t);
+}
+
+int vk_plan_adaptive_tiles(VkPhysicalDevice vk_phy_device, uint32_t image_width, uint32_t image_height, uint32_t local_size_x,
+                           fractal_output output, VkDeviceSize max_tile_bytes, vk_tile_plan* plan)
+{
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(vk_phy_device, &deviceProperties);
+
+    // The fill pass has up to one workgroup per block of the tile, a tile of uints has at most that many blocks of pixels
+    uint32_t max_blocks = deviceProperties.limits.maxComputeWorkGroupCount[0];
+    VkDeviceSize block_bytes = ADAPTIVE_BLOCK_SIZE * ADAPTIVE_BLOCK_SIZE * sizeof(uint32_t);
+    if ((VkDeviceSize)max_blocks * block_bytes < max_tile_bytes)
+    {
+        max_tile_bytes = (VkDeviceSize)max_blocks * block_bytes;
+    }
+    if (vk_plan_tiles(vk_phy_device, image_width, image_height, local_size_x, output, max_tile_bytes, plan) != 0)
+    {
+        return -1;
+    }
+
+    // Partial blocks along the edges can still push the tile over, keep it to whole rows of blocks that fit
+    uint32_t row_blocks = blocks_across(plan->tile_width);
+    if (vk_adaptive_block_count(plan) > max_blocks && row_blocks <= max_blocks)
+    {
+        VkDeviceSize rows = (VkDeviceSize)(max_blocks / row_blocks) * ADAPTIVE_BLOCK_SIZE;
+        return vk_plan_tiles(vk_phy_device, image_width, image_height, local_size_x, output,
+                             rows * vk_tile_row_bytes(plan, plan->tile_width), plan);
+    }
+    return 0;
+}
+
+int vk_check_adaptive(VkPhysicalDevice vk_phy_device, const vk_tile_plan* plan)
+{
+    // Blocks are filled pixel by pixel, the 8-bit counts share a uint between four pixels
+    if (plan->output == FRACTAL_OUTPUT_COUNT8)
+    {
+        printf("Adaptive rendering needs one uint per pixel, use the packed or rgba GPU output.\n");
+        return -1;
+    }
+
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(vk_phy_device, &deviceProperties);
+
+    // The border pass has one workgroup per block, the fill pass up to one per block in a row
+    const uint32_t* max_groups = deviceProperties.limits.maxComputeWorkGroupCount;
+    if (blocks_across(plan->tile_width) > max_groups[0] || blocks_across(plan->tile_height) > max_groups[1] ||
+        vk_adaptive_block_count(plan) > max_groups[0])
+    {
+        printf("Tiles of %u x %u have too many blocks for adaptive rendering.\n", plan->tile_width, plan->tile_height);
+        return -1;
+    }
+    return 0;
+}
+
+void vk_record_adaptive(
+    VkCommandBuffer vk_command_buffer,
+    VkPipeline vk_border_pipeline,
+    VkPipeline vk_fill_pipeline,
+    VkPipelineLayout vk_pipeline_layout,
+    VkDescriptorSet vk_descriptor_set,
+    const vk_tile_push_constants* tile,
+    VkBuffer vk_work_buffer,
+    VkQueryPool vk_query_pool,
+    uint32_t vk_query_index,
+    VkBuffer vk_output_buffer,
+    VkBuffer vk_staging_buffer,
+    VkDeviceSize readback_size)
+{
+    if (vk_query_pool != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(vk_command_buffer, vk_query_pool, vk_query_index, 2);
+        vkCmdWriteTimestamp(vk_command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, vk_query_pool, vk_query_index);
+    }
+
+    // The border pass appends to an empty work list
+    VkDispatchIndirectCommand command = { 0, 1, 1 };
+    vkCmdUpdateBuffer(vk_command_buffer, vk_work_buffer, 0, sizeof(command), &command);
+
+    // Also orders the shaders after a copy of the previous submission still reading the output buffer
+    VkMemoryBarrier memoryBarrier;
+    memset(&memoryBarrier, 0, sizeof(memoryBarrier));
+    memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(vk_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                         1, &memoryBarrier, 0, NULL, 0, NULL);
+
+    vkCmdBindDescriptorSets(vk_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, vk_pipeline_layout,
+                            0, 1, &vk_descriptor_set, 0, NULL);
+    vkCmdPushConstants(vk_command_buffer, vk_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(*tile), tile);
+
+    vkCmdBindPipeline(vk_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, vk_border_pipeline);
+    vkCmdDispatch(vk_command_buffer, blocks_across(tile->tile_width), blocks_across(tile->tile_height), 1);
+
+    // The fill pass reads its group count and block list from what the border pass appended
+    memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(vk_command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                         1, &memoryBarrier, 0, NULL, 0, NULL);
+
+    vkCmdBindPipeline(vk_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, vk_fill_pipeline);
+    vkCmdDispatchIndirect(vk_command_buffer, vk_work_buffer, 0);
+
+    if (vk_query_pool != VK_NULL_HANDLE)
+    {
+        vkCmdWriteTimestamp(vk_command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, vk_query_pool, vk_query_index + 1);
+    }
+
+    // The host reads back how many blocks needed the fill pass
+    memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(vk_command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+                         1, &memoryBarrier, 0, NULL, 0, NULL);
+
+    vk_record_output_barrier(vk_command_buffer, vk_output_buffer, vk_staging_buffer, readback_size);
+}
+
+#ifdef __cplusplus
+}
+#endif
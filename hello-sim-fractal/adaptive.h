@@ -0,0 +1,45 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <vulkan/vulkan.h>
+#include "tile.h"
+
+// Side of the square blocks the adaptive passes work on, blockSize in shader/fractal_adaptive_*.comp
+#define ADAPTIVE_BLOCK_SIZE 16
+
+// Blocks in the largest tile of the plan
+uint32_t vk_adaptive_block_count(const vk_tile_plan* plan);
+// Bytes of the work list: the fill pass's VkDispatchIndirectCommand, then one block index per block
+VkDeviceSize vk_adaptive_work_size(const vk_tile_plan* plan);
+// vk_plan_tiles with tiles small enough for the adaptive passes, so large images get more tiles
+// instead of failing vk_check_adaptive
+int vk_plan_adaptive_tiles(VkPhysicalDevice vk_phy_device, uint32_t image_width, uint32_t image_height, uint32_t local_size_x,
+                           fractal_output output, VkDeviceSize max_tile_bytes, vk_tile_plan* plan);
+// Returns -1 and prints why if the plan can't be rendered adaptively on this device
+int vk_check_adaptive(VkPhysicalDevice vk_phy_device, const vk_tile_plan* plan);
+
+// Records the adaptive render of one tile: the border pass renders every block border and fills the
+// uniform blocks, then the fill pass is dispatched indirectly over the remaining blocks only.
+// The work buffer needs indirect and transfer destination usage, its dispatch count is host-readable
+// afterwards. Timestamps and the readback work as in vk_record_dispatch.
+void vk_record_adaptive(
+    VkCommandBuffer vk_command_buffer,
+    VkPipeline vk_border_pipeline,
+    VkPipeline vk_fill_pipeline,
+    VkPipelineLayout vk_pipeline_layout,
+    VkDescriptorSet vk_descriptor_set,      // The work buffer is bound as the input buffer
+    const vk_tile_push_constants* tile,
+    VkBuffer vk_work_buffer,
+    VkQueryPool vk_query_pool,
+    uint32_t vk_query_index,
+    VkBuffer vk_output_buffer,
+    VkBuffer vk_staging_buffer,             // VK_NULL_HANDLE when the output buffer is read directly
+    VkDeviceSize readback_size
+);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,236 @@
+#include "animation.h"
+#include "vkrt/scheduler.h"
+
+#include <stdio.h>
+#include <string.h>
+
+int run_animation(const render_context* context)
+{
+    const render_options* options = context->options;
+    VkDevice vk_device = context->device;
+
+    // One pipeline covers the whole path, specialized for its largest iteration count
+    fractal_params cap_params = options->params;
+    if (options->zoom_max_iterations > cap_params.max_iterations)
+    {
+        cap_params.max_iterations = options->zoom_max_iterations;
+    }
+    VkPipeline vk_pipeline = vk_get_specialized_pipeline(vk_device, context->pipelines, context->plan->local_size_x, &cap_params);
+    if (vk_pipeline == VK_NULL_HANDLE)
+    {
+        return -1;
+    }
+
+    // Each tile in flight is copied into its own staging buffer, even when the output buffer is host-visible
+    struct readback_slot {
+        VkBuffer buffer;
+        vk_mapped_memory memory;
+        VkBuffer output_buffer;             // Transfer queue only
+        vk_mapped_memory output_memory;
+        VkDescriptorSet descriptor_set;
+        uint32_t submit_slot;               // Compute queue only
+        vk_scheduler* copy_scheduler;       // Transfer queue only, the copy signals copied on its timeline
+        uint64_t copied;
+        uint32_t frame;
+        uint32_t tile_index;
+        vk_tile_push_constants tile;
+    } slots[ANIMATION_READBACK_SLOTS];
+    memset(slots, 0, sizeof(slots));
+
+    // The copy of a tile waits on the compute timeline value of its render, the host on the transfer
+    // timeline value of the copy. A timeline only moves forward, so every queue gets its own scheduler.
+    bool split = !options->single_queue && context->queues->transfer_count > 0;
+    if (split && !context->queues->timeline_semaphores)
+    {
+        printf("Animation: no timeline semaphores, the transfer queue stays unused.\n");
+        split = false;
+    }
+    uint32_t families[2] = { context->queues->compute_family, context->queues->transfer_family };
+    vk_scheduler compute_schedulers[MAX_QUEUES_PER_FAMILY];
+    vk_scheduler transfer_schedulers[MAX_QUEUES_PER_FAMILY];
+    memset(compute_schedulers, 0, sizeof(compute_schedulers));
+    memset(transfer_schedulers, 0, sizeof(transfer_schedulers));
+
+    int result = 0;
+    for (uint32_t q = 0; split && q < context->queues->compute_count && result == 0; q++)
+    {
+        result = vk_create_scheduler(vk_device, context->queues->compute_family, ANIMATION_READBACK_SLOTS, &compute_schedulers[q]);
+    }
+    for (uint32_t q = 0; split && q < context->queues->transfer_count && result == 0; q++)
+    {
+        result = vk_create_scheduler(vk_device, context->queues->transfer_family, ANIMATION_READBACK_SLOTS, &transfer_schedulers[q]);
+    }
+    for (uint32_t s = 0; s < ANIMATION_READBACK_SLOTS && result == 0; s++)
+    {
+        slots[s].buffer = vk_create_buffer_and_memory(context->phy_device, vk_device, (uint32_t)context->plan->tile_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                      MEMORY_PLACEMENT_HOST_CACHED, &slots[s].memory);
+        if (slots[s].buffer == VK_NULL_HANDLE)
+        {
+            result = -1;
+        }
+        if (split && result == 0)
+        {
+            slots[s].output_buffer = vk_create_shared_buffer_and_memory(context->phy_device, vk_device, (uint32_t)context->plan->tile_size,
+                                                                        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                                                        MEMORY_PLACEMENT_DEVICE, 2, families, &slots[s].output_memory);
+            slots[s].descriptor_set = vk_create_descriptor_set(vk_device, context->descriptor_set_layout, context->descriptor_pool);
+            if (slots[s].output_buffer == VK_NULL_HANDLE || slots[s].descriptor_set == VK_NULL_HANDLE)
+            {
+                result = -1;
+                break;
+            }
+            vk_clone_descriptor_set(vk_device, context->descriptor_set, slots[s].descriptor_set, (uint32_t)context->plan->tile_size, slots[s].output_buffer);
+        }
+    }
+    char default_pattern[32];
+    snprintf(default_pattern, sizeof(default_pattern), "fractal_%%04u.%s", export_format_extension(options->output_format, gpu_pixels(options)));
+    const char* pattern = options->frame_pattern != NULL ? options->frame_pattern : default_pattern;
+
+    frame_exporter* exporter = exporter_create(options->width, options->height, gpu_pixels(options), options->output_format, options->export_threads, 0);
+    void* frame_image = NULL;
+
+    fractal_params last_params = zoom_params(options, options->animate_frames - 1, options->animate_frames);
+    printf("Animation: %u frames, scale %g to %g, %s\n", options->animate_frames, options->params.scale, last_params.scale,
+           split ? "read back on the transfer queue" : "read back on the compute queue");
+
+    uint32_t tile_count = vk_tile_count(context->plan);
+    uint32_t job_count = options->animate_frames * tile_count;
+    uint32_t lag = ANIMATION_READBACK_SLOTS - 1;
+    double time = getTime();
+
+    for (uint32_t job = 0; job < job_count + lag && result == 0; job++)
+    {
+        // Submit tile `job` before reading back tile `job - lag`
+        if (job < job_count)
+        {
+            readback_slot* slot = &slots[job % ANIMATION_READBACK_SLOTS];
+            slot->frame = job / tile_count;
+            slot->tile_index = job % tile_count;
+
+            fractal_params frame_params = zoom_params(options, slot->frame, options->animate_frames);
+            vk_get_tile(context->plan, slot->tile_index, &frame_params, &slot->tile);
+
+            uint32_t tile_size = vk_tile_row_bytes(context->plan, slot->tile.tile_width) * slot->tile.tile_height;
+            uint32_t group_count_x = vk_tile_group_count_x(context->plan, slot->tile.tile_width);
+            if (!split)
+            {
+                // Tiles sharing vk_output_buffer are ordered by barriers, so they must stay on one queue
+                VkCommandBuffer vk_command_buffer = vk_begin_submit(vk_device, context->submit);
+                if (vk_command_buffer == VK_NULL_HANDLE)
+                {
+                    result = -1;
+                    break;
+                }
+                slot->submit_slot = context->submit->next;
+                vk_record_dispatch(vk_command_buffer, vk_pipeline, context->pipeline_layout, context->descriptor_set, &slot->tile, sizeof(slot->tile),
+                                   group_count_x, slot->tile.tile_height, VK_NULL_HANDLE, 0, context->output_buffer, slot->buffer, tile_size);
+                result = vk_end_submit(vk_device, context->queues->compute[0], context->submit);
+            }
+            else
+            {
+                uint32_t compute_queue = job % context->queues->compute_count;
+                uint32_t transfer_queue = job % context->queues->transfer_count;
+                vk_scheduler* compute_scheduler = &compute_schedulers[compute_queue];
+                slot->copy_scheduler = &transfer_schedulers[transfer_queue];
+
+                // The slot's output buffer was last read by a copy the host has already waited for
+                VkCommandBuffer vk_command_buffer = vk_scheduler_begin(vk_device, compute_scheduler);
+                if (vk_command_buffer == VK_NULL_HANDLE)
+                {
+                    result = -1;
+                    break;
+                }
+                vk_record_dispatch(vk_command_buffer, vk_pipeline, context->pipeline_layout, slot->descriptor_set, &slot->tile, sizeof(slot->tile),
+                                   group_count_x, slot->tile.tile_height, VK_NULL_HANDLE, 0, slot->output_buffer, VK_NULL_HANDLE, 0);
+
+                vk_timeline_wait rendered;
+                rendered.timeline = compute_scheduler->timeline;
+                rendered.value = vk_scheduler_submit(context->queues->compute[compute_queue], compute_scheduler, NULL, 0);
+                rendered.stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+                vk_command_buffer = rendered.value != 0 ? vk_scheduler_begin(vk_device, slot->copy_scheduler) : VK_NULL_HANDLE;
+                if (vk_command_buffer == VK_NULL_HANDLE)
+                {
+                    result = -1;
+                    break;
+                }
+                vk_record_readback(vk_command_buffer, slot->output_buffer, slot->buffer, tile_size);
+                slot->copied = vk_scheduler_submit(context->queues->transfer[transfer_queue], slot->copy_scheduler, &rendered, 1);
+                result = slot->copied != 0 ? 0 : -1;
+            }
+        }
+
+        if (job >= lag && result == 0)
+        {
+            const readback_slot* slot = &slots[(job - lag) % ANIMATION_READBACK_SLOTS];
+            result = split ? vk_scheduler_wait(vk_device, slot->copy_scheduler, slot->copied) : vk_wait_submit(vk_device, context->submit, slot->submit_slot);
+            if (result != 0)
+            {
+                break;
+            }
+
+            // A frame takes a buffer from the exporter with its first tile and hands it back with its last one
+            if (frame_image == NULL)
+            {
+                frame_image = exporter_acquire(exporter);
+            }
+            copy_tile_to_image(vk_device, frame_image, gpu_pixels(options), context->plan, &slot->tile, &slot->memory);
+
+            if (slot->tile_index == tile_count - 1)
+            {
+                char filename[256];
+                snprintf(filename, sizeof(filename), pattern, slot->frame);
+                exporter_submit(exporter, frame_image, filename);
+                frame_image = NULL;
+            }
+        }
+    }
+
+    // Nothing may still be writing the staging buffers when they are destroyed
+    if (vk_wait_submit_context(vk_device, context->submit) != 0)
+    {
+        result = -1;
+    }
+    for (uint32_t q = 0; q < MAX_QUEUES_PER_FAMILY; q++)
+    {
+        if ((compute_schedulers[q].timeline != VK_NULL_HANDLE && vk_scheduler_wait_idle(vk_device, &compute_schedulers[q]) != 0) ||
+            (transfer_schedulers[q].timeline != VK_NULL_HANDLE && vk_scheduler_wait_idle(vk_device, &transfer_schedulers[q]) != 0))
+        {
+            result = -1;
+        }
+    }
+    double render_time = getTime() - time;
+
+    if (exporter_finish(exporter) != 0)
+    {
+        result = -1;
+    }
+    time = getTime() - time;
+
+    if (result == 0)
+    {
+        printf("Animation: %f ms per frame, %.1f frames/s sustained, rendering stalled %f ms waiting for the writers.\n",
+               time / 1000.0 / options->animate_frames, options->animate_frames / (time / 1000000.0), exporter_stall_time(exporter) / 1000.0);
+        printf("Animation: GPU done after %f ms, writers after %f ms.\n", render_time / 1000.0, time / 1000.0);
+    }
+    exporter_destroy(exporter);
+
+    // The descriptor sets go with the pool
+    for (uint32_t s = 0; s < ANIMATION_READBACK_SLOTS; s++)
+    {
+        if (slots[s].buffer != VK_NULL_HANDLE)
+        {
+            vk_destroy_buffer(vk_device, slots[s].buffer, &slots[s].memory);
+        }
+        if (slots[s].output_buffer != VK_NULL_HANDLE)
+        {
+            vk_destroy_buffer(vk_device, slots[s].output_buffer, &slots[s].output_memory);
+        }
+    }
+    for (uint32_t q = 0; q < MAX_QUEUES_PER_FAMILY; q++)
+    {
+        vk_destroy_scheduler(vk_device, &compute_schedulers[q]);
+        vk_destroy_scheduler(vk_device, &transfer_schedulers[q]);
+    }
+    return result;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "render.h"
+
+// Staging buffers in the readback ring, all but one tile can render while the oldest one is read back
+#define ANIMATION_READBACK_SLOTS 3
+
+// Renders the zoom path to fractal_0000.png, fractal_0001.png, ... Only the push constants change between
+// frames, tiles render on the GPU while older ones are read back, and worker threads encode the frames.
+// With a transfer queue every slot has its own output buffer, and the copy of one tile runs on the
+// transfer queue while the compute queues render the next ones.
+int run_animation(const render_context* context);
+
+#ifdef __cplusplus
+}
+#endif
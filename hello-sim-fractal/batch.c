@@ -0,0 +1,188 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "batch.h"
+#include <stdio.h>
+#include <string.h>
+
+static VkDeviceSize job_bytes(const vk_tile_plan* plan, const vk_batch_job* job)
+{
+    return (VkDeviceSize)vk_tile_row_bytes(plan, job->width) * job->height;
+}
+
+// Checks every job against the device limits before anything is recorded
+static int check_jobs(VkPhysicalDevice vk_phy_device, const vk_tile_plan* plan, const vk_batch_job* jobs, uint32_t job_count)
+{
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(vk_phy_device, &deviceProperties);
+
+    for (uint32_t i = 0; i < job_count; i++)
+    {
+        const vk_batch_job* job = &jobs[i];
+        if (job->width == 0 || job->height == 0 ||
+            vk_tile_group_count_x(plan, job->width) > deviceProperties.limits.maxComputeWorkGroupCount[0] ||
+            job->height > deviceProperties.limits.maxComputeWorkGroupCount[1] ||
+            job_bytes(plan, job) > plan->tile_size)
+        {
+            printf("Batch job %u (%ux%u) doesn't fit a single dispatch.\n", i, job->width, job->height);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Jobs write disjoint ranges of the output buffer, so they need no barriers between them
+static void record_jobs(
+    VkCommandBuffer vk_command_buffer,
+    VkPipeline vk_pipeline,
+    VkPipelineLayout vk_pipeline_layout,
+    VkDescriptorSet vk_descriptor_set,
+    const vk_tile_plan* plan,
+    VkBuffer vk_output_buffer,
+    VkBuffer vk_staging_buffer,
+    const vk_batch_job* jobs,
+    uint32_t job_count,
+    VkDeviceSize used)
+{
+    vkCmdBindPipeline(vk_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, vk_pipeline);
+    vkCmdBindDescriptorSets(vk_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, vk_pipeline_layout,
+                            0, 1, &vk_descriptor_set, 0, NULL);
+
+    VkDeviceSize offset = 0;
+    for (uint32_t i = 0; i < job_count; i++)
+    {
+        const vk_batch_job* job = &jobs[i];
+
+        vk_tile_push_constants tile;
+        memset(&tile, 0, sizeof(tile));
+        tile.image_width = job->width;
+        tile.image_height = job->height;
+        tile.tile_width = job->width;
+        tile.tile_height = job->height;
+        tile.center_real = (float)job->params.center_real;
+        tile.center_imag = (float)job->params.center_imag;
+        tile.scale = (float)job->params.scale;
+        tile.iterations = job->params.max_iterations;
+        tile.output_offset = (uint32_t)(offset / sizeof(uint32_t));
+
+        vkCmdPushConstants(vk_command_buffer, vk_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(tile), &tile);
+        vkCmdDispatch(vk_command_buffer, vk_tile_group_count_x(plan, job->width), job->height, 1);
+
+        offset += job_bytes(plan, job);
+    }
+
+    VkBufferMemoryBarrier bufferBarrier;
+    memset(&bufferBarrier, 0, sizeof(bufferBarrier));
+    bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    bufferBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufferBarrier.buffer = vk_output_buffer;
+    bufferBarrier.offset = 0;
+    bufferBarrier.size = used;
+
+    // One barrier covers the whole batch
+    if (vk_staging_buffer != VK_NULL_HANDLE)
+    {
+        bufferBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        vkCmdPipelineBarrier(vk_command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                             0, NULL, 1, &bufferBarrier, 0, NULL);
+        vk_record_readback(vk_command_buffer, vk_output_buffer, vk_staging_buffer, used);
+    }
+    else
+    {
+        bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(vk_command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+                             0, NULL, 1, &bufferBarrier, 0, NULL);
+    }
+}
+
+// Copies the jobs out of the mapped readback memory, dropping the padding of 8-bit count rows
+static void copy_jobs(VkDevice vk_device, const vk_tile_plan* plan, const vk_mapped_memory* vk_readback_memory,
+                      const vk_batch_job* jobs, uint32_t job_count, VkDeviceSize used)
+{
+    vk_invalidate_mapped_memory(vk_device, vk_readback_memory, 0, used);
+
+    uint32_t pixel_bytes = plan->output == FRACTAL_OUTPUT_COUNT8 ? 1 : 4;
+    const unsigned char* data = (const unsigned char*)vk_readback_memory->address;
+
+    for (uint32_t i = 0; i < job_count; i++)
+    {
+        const vk_batch_job* job = &jobs[i];
+        uint32_t row_bytes = vk_tile_row_bytes(plan, job->width);
+        size_t pixel_row_bytes = (size_t)job->width * pixel_bytes;
+
+        if (row_bytes == pixel_row_bytes)
+        {
+            memcpy(job->pixels, data, pixel_row_bytes * job->height);
+        }
+        else
+        {
+            for (uint32_t row = 0; row < job->height; row++)
+            {
+                memcpy((unsigned char*)job->pixels + row * pixel_row_bytes, data + (size_t)row * row_bytes, pixel_row_bytes);
+            }
+        }
+        data += job_bytes(plan, job);
+    }
+}
+
+int vk_run_batch(
+    VkPhysicalDevice vk_phy_device,
+    VkDevice vk_device,
+    VkQueue vk_queue_compute,
+    vk_submit_context* vk_submit,
+    VkPipeline vk_pipeline,
+    VkPipelineLayout vk_pipeline_layout,
+    VkDescriptorSet vk_descriptor_set,
+    const vk_tile_plan* plan,
+    VkBuffer vk_output_buffer,
+    VkBuffer vk_staging_buffer,
+    const vk_mapped_memory* vk_readback_memory,
+    const vk_batch_job* jobs,
+    uint32_t job_count)
+{
+    if (check_jobs(vk_phy_device, plan, jobs, job_count) != 0)
+    {
+        return -1;
+    }
+
+    int submissions = 0;
+    uint32_t first = 0;
+    while (first < job_count)
+    {
+        // Take as many jobs as the output buffer holds
+        uint32_t count = 0;
+        VkDeviceSize used = 0;
+        while (first + count < job_count && used + job_bytes(plan, &jobs[first + count]) <= plan->tile_size)
+        {
+            used += job_bytes(plan, &jobs[first + count]);
+            count++;
+        }
+
+        VkCommandBuffer vk_command_buffer = vk_begin_submit(vk_device, vk_submit);
+        if (vk_command_buffer == VK_NULL_HANDLE)
+        {
+            return -1;
+        }
+        record_jobs(vk_command_buffer, vk_pipeline, vk_pipeline_layout, vk_descriptor_set, plan,
+                    vk_output_buffer, vk_staging_buffer, jobs + first, count, used);
+
+        if (vk_end_submit(vk_device, vk_queue_compute, vk_submit) != 0 ||
+            vk_wait_submit_context(vk_device, vk_submit) != 0)
+        {
+            return -1;
+        }
+
+        copy_jobs(vk_device, plan, vk_readback_memory, jobs + first, count, used);
+
+        first += count;
+        submissions++;
+    }
+    return submissions;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <vulkan/vulkan.h>
+#include "vkrt/compute.h"
+#include "fractal_params.h"
+#include "vkrt/memory.h"
+#include "tile.h"
+
+// One independent render of a batch, small enough for a single dispatch
+typedef struct vk_batch_job {
+    uint32_t width;
+    uint32_t height;
+    fractal_params params;      // View and iteration count, the Julia constant and output format are the pipeline's
+    void* pixels;               // Receives width * height pixels in the plan's output format, rows without padding
+} vk_batch_job;
+
+// Renders the jobs back to back in the output buffer. Each buffer-full of jobs is recorded into one
+// command buffer with a single barrier and readback, submitted once and waited for once.
+// Returns the number of submissions, or -1 if a job doesn't fit a single dispatch or the submission fails.
+int vk_run_batch(
+    VkPhysicalDevice vk_phy_device,
+    VkDevice vk_device,
+    VkQueue vk_queue_compute,
+    vk_submit_context* vk_submit,
+    VkPipeline vk_pipeline,
+    VkPipelineLayout vk_pipeline_layout,
+    VkDescriptorSet vk_descriptor_set,
+    const vk_tile_plan* plan,               // Local size and output format, tile_size is the capacity of the output buffer
+    VkBuffer vk_output_buffer,
+    VkBuffer vk_staging_buffer,             // VK_NULL_HANDLE when the output buffer is read directly
+    const vk_mapped_memory* vk_readback_memory,
+    const vk_batch_job* jobs,
+    uint32_t job_count
+);
+
+#ifdef __cplusplus
+}
+#endif
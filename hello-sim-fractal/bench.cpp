@@ -0,0 +1,141 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <stdio.h>
+
+// Linear interpolation between the closest ranks of a sorted series
+static double percentile(const std::vector<double>& sorted, double p)
+{
+    double rank = p * (sorted.size() - 1);
+    size_t lo = (size_t)rank;
+    size_t hi = std::min(lo + 1, sorted.size() - 1);
+    return sorted[lo] + (sorted[hi] - sorted[lo]) * (rank - lo);
+}
+
+void bench_compute_stats(const double* samples, uint32_t count, bench_stats* stats)
+{
+    *stats = {};
+    if (count == 0)
+    {
+        return;
+    }
+
+    std::vector<double> sorted(samples, samples + count);
+    std::sort(sorted.begin(), sorted.end());
+
+    double sum = 0.0;
+    for (double s : sorted)
+    {
+        sum += s;
+    }
+    double mean = sum / count;
+
+    double squares = 0.0;
+    for (double s : sorted)
+    {
+        squares += (s - mean) * (s - mean);
+    }
+
+    stats->count = count;
+    stats->min = sorted.front();
+    stats->max = sorted.back();
+    stats->mean = mean;
+    stats->median = percentile(sorted, 0.50);
+    stats->p95 = percentile(sorted, 0.95);
+    stats->p99 = percentile(sorted, 0.99);
+    stats->stddev = count > 1 ? std::sqrt(squares / (count - 1)) : 0.0;
+}
+
+void bench_print_stats(const char* label, const bench_stats* stats, const char* unit)
+{
+    if (stats->count == 0)
+    {
+        printf("%-12s n/a\n", label);
+        return;
+    }
+    printf("%-12s min %.3f  median %.3f  p95 %.3f  p99 %.3f  max %.3f  stddev %.3f %s (n=%u)\n", label,
+           stats->min, stats->median, stats->p95, stats->p99, stats->max, stats->stddev, unit, stats->count);
+}
+
+static void write_json_string(FILE* file, const char* s)
+{
+    fputc('"', file);
+    for (; s != NULL && *s != '\0'; s++)
+    {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\')
+        {
+            fprintf(file, "\\%c", c);
+        }
+        else if (c < 0x20)
+        {
+            fprintf(file, "\\u%04x", c);
+        }
+        else
+        {
+            fputc(c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+static void write_json_stats(FILE* file, const char* name, const bench_stats* stats, bool last)
+{
+    fprintf(file, "    \"%s\": ", name);
+    if (stats->count == 0)
+    {
+        fprintf(file, "null%s\n", last ? "" : ",");
+        return;
+    }
+    fprintf(file, "{ \"count\": %u, \"min\": %.6f, \"max\": %.6f, \"mean\": %.6f, \"median\": %.6f, "
+                  "\"p95\": %.6f, \"p99\": %.6f, \"stddev\": %.6f }%s\n",
+            stats->count, stats->min, stats->max, stats->mean, stats->median, stats->p95, stats->p99, stats->stddev,
+            last ? "" : ",");
+}
+
+int bench_write_json(const char* path, const bench_report* report)
+{
+    bool to_stdout = path[0] == '-' && path[1] == '\0';
+    FILE* file = to_stdout ? stdout : fopen(path, "w");
+    if (file == NULL)
+    {
+        printf("Failed to open %s for writing.\n", path);
+        return -1;
+    }
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"device\": {\n");
+    fprintf(file, "    \"name\": ");
+    write_json_string(file, report->device_name);
+    fprintf(file, ",\n");
+    fprintf(file, "    \"vendor_id\": %u,\n", report->vendor_id);
+    fprintf(file, "    \"device_id\": %u,\n", report->device_id);
+    fprintf(file, "    \"driver_version\": %u,\n", report->driver_version);
+    fprintf(file, "    \"api_version\": \"%u.%u.%u\"\n", report->api_version >> 22, (report->api_version >> 12) & 0x3ff,
+            report->api_version & 0xfff);
+    fprintf(file, "  },\n");
+    fprintf(file, "  \"width\": %u,\n", report->width);
+    fprintf(file, "  \"height\": %u,\n", report->height);
+    fprintf(file, "  \"tiles\": %u,\n", report->tiles);
+    fprintf(file, "  \"warmup\": %u,\n", report->warmup);
+    fprintf(file, "  \"iterations\": %u,\n", report->iterations);
+    fprintf(file, "  \"cpu_backend\": ");
+    write_json_string(file, report->cpu_backend);
+    fprintf(file, ",\n");
+    fprintf(file, "  \"cpu_threads\": %u,\n", report->cpu_threads);
+    fprintf(file, "  \"timings_ms\": {\n");
+    write_json_stats(file, "cpu_wall", &report->cpu_wall, false);
+    write_json_stats(file, "gpu_wall", &report->gpu_wall, false);
+    write_json_stats(file, "gpu_device", &report->gpu_device, true);
+    fprintf(file, "  }\n");
+    fprintf(file, "}\n");
+
+    if (!to_stdout)
+    {
+        fclose(file);
+    }
+    return 0;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// Summary of a series of timing samples, in the unit of the samples
+typedef struct bench_stats {
+    uint32_t count;
+    double min;
+    double max;
+    double mean;
+    double median;
+    double p95;
+    double p99;
+    double stddev;
+} bench_stats;
+
+// Everything needed to reproduce and compare a benchmark run
+typedef struct bench_report {
+    const char* device_name;
+    uint32_t vendor_id;
+    uint32_t device_id;
+    uint32_t driver_version;
+    uint32_t api_version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t tiles;
+    uint32_t warmup;
+    uint32_t iterations;
+    const char* cpu_backend;
+    uint32_t cpu_threads;
+    bench_stats cpu_wall;       // milliseconds
+    bench_stats gpu_wall;
+    bench_stats gpu_device;     // count is 0 when the queue has no timestamp support
+} bench_report;
+
+void bench_compute_stats(const double* samples, uint32_t count, bench_stats* stats);
+void bench_print_stats(const char* label, const bench_stats* stats, const char* unit);
+
+// Writes the report as JSON to path, "-" means stdout
+int bench_write_json(const char* path, const bench_report* report);
+
+#ifdef __cplusplus
+}
+#endif
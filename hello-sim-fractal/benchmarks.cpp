@@ -0,0 +1,341 @@
+#include "benchmarks.h"
+#include "bench.h"
+#include "batch.h"
+#include "adaptive.h"
+#include "vkrt/instance.h"
+
+#include <vector>
+
+#include <stdio.h>
+
+int run_benchmark(const render_context* context, VkPipeline vk_pipeline)
+{
+    const render_options* options = context->options;
+    VkDevice vk_device = context->device;
+
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(context->phy_device, &deviceProperties);
+
+    VkQueueFamilyProperties families[MAX_QUEUE_FAMILY];
+    uint32_t family_count = MAX_QUEUE_FAMILY;
+    vkGetPhysicalDeviceQueueFamilyProperties(context->phy_device, &family_count, families);
+
+    // Device-side times come from a pair of timestamps around every tile dispatch
+    uint32_t valid_bits = families[context->queues->compute_family].timestampValidBits;
+    double timestamp_period = deviceProperties.limits.timestampPeriod;
+    uint32_t tile_count = vk_tile_count(context->plan);
+
+    VkQueryPool vk_query_pool = VK_NULL_HANDLE;
+    if (valid_bits > 0 && timestamp_period > 0.0)
+    {
+        vk_query_pool = vk_create_timestamp_query_pool(vk_device, 2 * tile_count);
+    }
+    if (vk_query_pool == VK_NULL_HANDLE)
+    {
+        printf("Timestamps are not supported on this queue, reporting wall-clock times only.\n");
+    }
+
+    printf("Benchmark: %u warmup + %u timed iterations\n", options->bench_warmup, options->bench_iterations);
+
+    std::vector<double> cpu_wall, gpu_wall, gpu_device;
+    for (uint32_t i = 0; i < options->bench_warmup + options->bench_iterations; i++)
+    {
+        double time = getTime();
+        generate_fractal_cpu(options, context->image);
+        time = getTime() - time;
+        if (i >= options->bench_warmup)
+        {
+            cpu_wall.push_back(time / 1000.0);
+        }
+    }
+
+    int result = 0;
+    for (uint32_t i = 0; i < options->bench_warmup + options->bench_iterations && result == 0; i++)
+    {
+        double time = getTime();
+        result = generate_fractal_gpu(context, vk_pipeline, &options->params, vk_query_pool);
+        time = getTime() - time;
+        if (result != 0 || i < options->bench_warmup)
+        {
+            continue;
+        }
+        gpu_wall.push_back(time / 1000.0);
+
+        uint64_t ticks = 0;
+        if (vk_query_pool != VK_NULL_HANDLE)
+        {
+            result = vk_get_timestamp_ticks(vk_device, vk_query_pool, tile_count, valid_bits, &ticks);
+            gpu_device.push_back(ticks * timestamp_period / 1000000.0);
+        }
+    }
+
+    if (vk_query_pool != VK_NULL_HANDLE)
+    {
+        vkDestroyQueryPool(vk_device, vk_query_pool, NULL);
+    }
+    if (result != 0)
+    {
+        return result;
+    }
+
+    bench_report report = {};
+    report.device_name = deviceProperties.deviceName;
+    report.vendor_id = deviceProperties.vendorID;
+    report.device_id = deviceProperties.deviceID;
+    report.driver_version = deviceProperties.driverVersion;
+    report.api_version = deviceProperties.apiVersion;
+    report.width = options->width;
+    report.height = options->height;
+    report.tiles = tile_count;
+    report.warmup = options->bench_warmup;
+    report.iterations = options->bench_iterations;
+    report.cpu_backend = cpu_simd_level_as_string(options->cpu_level);
+    report.cpu_threads = options->cpu_threads;
+    bench_compute_stats(cpu_wall.data(), (uint32_t)cpu_wall.size(), &report.cpu_wall);
+    bench_compute_stats(gpu_wall.data(), (uint32_t)gpu_wall.size(), &report.gpu_wall);
+    bench_compute_stats(gpu_device.data(), (uint32_t)gpu_device.size(), &report.gpu_device);
+
+    bench_print_stats("CPU wall", &report.cpu_wall, "ms");
+    bench_print_stats("GPU wall", &report.gpu_wall, "ms");
+    bench_print_stats("GPU device", &report.gpu_device, "ms");
+
+    if (options->bench_json != NULL)
+    {
+        return bench_write_json(options->bench_json, &report);
+    }
+    return 0;
+}
+
+int run_adaptive_benchmark(const render_context* context, VkPipeline vk_pipeline, VkPipeline vk_border_pipeline, VkPipeline vk_fill_pipeline)
+{
+    const render_options* options = context->options;
+    const char* labels[4] = { "CPU full", "CPU adaptive", "GPU full", "GPU adaptive" };
+    std::vector<double> samples[4];
+    uint64_t evaluated = 0;
+    uint64_t unresolved_blocks = 0;
+
+    printf("Adaptive benchmark: %u warmup + %u timed iterations, max iterations %u\n", options->bench_warmup, options->bench_iterations,
+           options->params.max_iterations);
+
+    for (uint32_t mode = 0; mode < 4; mode++)
+    {
+        for (uint32_t i = 0; i < options->bench_warmup + options->bench_iterations; i++)
+        {
+            int result = 0;
+            double time = getTime();
+            switch (mode)
+            {
+            case 0:
+                generate_fractal_cpu(options, context->image);
+                break;
+
+            case 1:
+                evaluated = generate_fractal_cpu_adaptive(options, context->image);
+                break;
+
+            case 2:
+                result = generate_fractal_gpu(context, vk_pipeline, &options->params, VK_NULL_HANDLE);
+                break;
+
+            default:
+                result = generate_fractal_gpu_adaptive(context, vk_border_pipeline, vk_fill_pipeline, &options->params, VK_NULL_HANDLE,
+                                                       &unresolved_blocks);
+                break;
+            }
+            time = getTime() - time;
+            if (result != 0)
+            {
+                return result;
+            }
+
+            if (i >= options->bench_warmup)
+            {
+                samples[mode].push_back(time / 1000.0);
+            }
+        }
+    }
+
+    // Every tile has the blocks of a full tile except along the right and bottom edge
+    uint64_t blocks = 0;
+    for (uint32_t t = 0; t < vk_tile_count(context->plan); t++)
+    {
+        vk_tile_push_constants tile;
+        vk_get_tile(context->plan, t, &options->params, &tile);
+        blocks += (uint64_t)((tile.tile_width + ADAPTIVE_BLOCK_SIZE - 1) / ADAPTIVE_BLOCK_SIZE) *
+                  ((tile.tile_height + ADAPTIVE_BLOCK_SIZE - 1) / ADAPTIVE_BLOCK_SIZE);
+    }
+    printf("CPU adaptive: iterated %.1f%% of the pixels\n", 100.0 * evaluated / ((double)options->width * options->height));
+    printf("GPU adaptive: %llu of %llu blocks (%.1f%%) needed the fill pass\n", (unsigned long long)unresolved_blocks,
+           (unsigned long long)blocks, 100.0 * unresolved_blocks / blocks);
+
+    bench_stats stats[4];
+    for (uint32_t mode = 0; mode < 4; mode++)
+    {
+        bench_compute_stats(samples[mode].data(), (uint32_t)samples[mode].size(), &stats[mode]);
+        bench_print_stats(labels[mode], &stats[mode], "ms");
+    }
+    printf("Speedup (median): CPU %.2fx, GPU %.2fx\n", stats[0].median / stats[1].median, stats[2].median / stats[3].median);
+    return 0;
+}
+
+int run_dispatch_benchmark(const render_context* context, VkPipeline vk_pipeline)
+{
+    const render_options* options = context->options;
+    const fractal_params* params = &options->params;
+    VkDevice vk_device = context->device;
+    VkQueue vk_queue_compute = context->queues->compute[0];
+    uint32_t dispatches = options->bench_dispatches;
+
+    // Every dispatch writes the same first local_size_x pixels, nothing is read back
+    uint32_t tile_width = options->width < options->local_size_x ? options->width : options->local_size_x;
+    vk_tile_push_constants tile = { options->width, options->height, 0, 0, tile_width, 1,
+                                    (float)params->center_real, (float)params->center_imag, (float)params->scale, params->max_iterations };
+
+    const char* labels[3] = { "Per call", "Ring, wait", "Ring, async" };
+    std::vector<double> samples[3];
+
+    printf("Dispatch benchmark: %u x %u dispatches after %u warmup batches\n", options->bench_iterations, dispatches, options->bench_warmup);
+
+    for (uint32_t mode = 0; mode < 3; mode++)
+    {
+        for (uint32_t i = 0; i < options->bench_warmup + options->bench_iterations; i++)
+        {
+            double time = getTime();
+            for (uint32_t d = 0; d < dispatches; d++)
+            {
+                int result = 0;
+                if (mode == 0)
+                {
+                    // A new command buffer and fence for every dispatch
+                    VkCommandBuffer vk_command_buffer = vk_prepare_command_buffer(vk_device, vk_pipeline, context->pipeline_layout, context->descriptor_set,
+                                                                                  context->command_pool, &tile, sizeof(tile), 1, 1, VK_NULL_HANDLE, 0,
+                                                                                  context->output_buffer, VK_NULL_HANDLE, 0);
+                    result = vk_command_buffer == VK_NULL_HANDLE ? -1 : vk_compute(vk_device, vk_queue_compute, vk_command_buffer);
+                    vkFreeCommandBuffers(vk_device, context->command_pool, 1, &vk_command_buffer);
+                }
+                else
+                {
+                    // Reused command buffers and fences, optionally keeping the ring full
+                    VkCommandBuffer vk_command_buffer = vk_begin_submit(vk_device, context->submit);
+                    if (vk_command_buffer == VK_NULL_HANDLE)
+                    {
+                        return -1;
+                    }
+                    vk_record_dispatch(vk_command_buffer, vk_pipeline, context->pipeline_layout, context->descriptor_set, &tile, sizeof(tile), 1, 1,
+                                       VK_NULL_HANDLE, 0, context->output_buffer, VK_NULL_HANDLE, 0);
+                    result = vk_end_submit(vk_device, vk_queue_compute, context->submit);
+                    if (result == 0 && mode == 1)
+                    {
+                        result = vk_wait_submit_context(vk_device, context->submit);
+                    }
+                }
+                if (result != 0)
+                {
+                    return result;
+                }
+            }
+            if (vk_wait_submit_context(vk_device, context->submit) != 0)
+            {
+                return -1;
+            }
+            time = getTime() - time;
+
+            if (i >= options->bench_warmup)
+            {
+                samples[mode].push_back(time / dispatches);
+            }
+        }
+    }
+
+    for (uint32_t mode = 0; mode < 3; mode++)
+    {
+        bench_stats stats;
+        bench_compute_stats(samples[mode].data(), (uint32_t)samples[mode].size(), &stats);
+        bench_print_stats(labels[mode], &stats, "us");
+    }
+    return 0;
+}
+
+int run_batch_benchmark(const render_context* context)
+{
+    const render_options* options = context->options;
+    VkDevice vk_device = context->device;
+    VkQueue vk_queue_compute = context->queues->compute[0];
+    uint32_t job_count = options->bench_batch_jobs;
+
+    // The iteration counts are push constants, one pipeline covers every job
+    fractal_params cap_params = options->params;
+    if (options->zoom_max_iterations > cap_params.max_iterations)
+    {
+        cap_params.max_iterations = options->zoom_max_iterations;
+    }
+    VkPipeline vk_pipeline = vk_get_specialized_pipeline(vk_device, context->pipelines, context->plan->local_size_x, &cap_params);
+    if (vk_pipeline == VK_NULL_HANDLE)
+    {
+        return -1;
+    }
+
+    size_t job_bytes = (size_t)options->width * options->height * export_pixel_bytes(gpu_pixels(options));
+    std::vector<unsigned char> pixels(job_bytes * job_count);
+    std::vector<vk_batch_job> jobs(job_count);
+    for (uint32_t j = 0; j < job_count; j++)
+    {
+        jobs[j].width = options->width;
+        jobs[j].height = options->height;
+        jobs[j].params = zoom_params(options, j, job_count);
+        jobs[j].pixels = pixels.data() + j * job_bytes;
+    }
+
+    const char* labels[2] = { "Batched", "Per job" };
+    std::vector<double> samples[2];
+    int submissions = 0;
+
+    printf("Batch benchmark: %u x %u jobs of %u x %u after %u warmup batches\n", options->bench_iterations, job_count,
+           options->width, options->height, options->bench_warmup);
+
+    for (uint32_t mode = 0; mode < 2; mode++)
+    {
+        for (uint32_t i = 0; i < options->bench_warmup + options->bench_iterations; i++)
+        {
+            double time = getTime();
+            if (mode == 0)
+            {
+                submissions = vk_run_batch(context->phy_device, vk_device, vk_queue_compute, context->submit, vk_pipeline, context->pipeline_layout,
+                                           context->descriptor_set, context->plan, context->output_buffer, context->staging_buffer,
+                                           context->readback_memory, jobs.data(), job_count);
+                if (submissions < 0)
+                {
+                    return -1;
+                }
+            }
+            else
+            {
+                // The same jobs, each recorded, submitted and waited for on its own
+                for (uint32_t j = 0; j < job_count; j++)
+                {
+                    if (vk_run_batch(context->phy_device, vk_device, vk_queue_compute, context->submit, vk_pipeline, context->pipeline_layout,
+                                     context->descriptor_set, context->plan, context->output_buffer, context->staging_buffer,
+                                     context->readback_memory, &jobs[j], 1) < 0)
+                    {
+                        return -1;
+                    }
+                }
+            }
+            time = getTime() - time;
+
+            if (i >= options->bench_warmup)
+            {
+                samples[mode].push_back(time / job_count);
+            }
+        }
+    }
+
+    printf("Batch: %u jobs fit in %d submissions\n", job_count, submissions);
+    for (uint32_t mode = 0; mode < 2; mode++)
+    {
+        bench_stats stats;
+        bench_compute_stats(samples[mode].data(), (uint32_t)samples[mode].size(), &stats);
+        bench_print_stats(labels[mode], &stats, "us");
+    }
+    return 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <vulkan/vulkan.h>
+#include "render.h"
+
+// Wall-clock times of the CPU and GPU renders of the view, and the device-side GPU time from timestamps
+// around every tile when the queue has them. Writes the report to bench_json when it is set.
+int run_benchmark(const render_context* context, VkPipeline vk_pipeline);
+
+// Wall-clock time of full and adaptive renders of the same view on the CPU and the GPU, in milliseconds,
+// with the share of the image the adaptive renders still had to iterate
+int run_adaptive_benchmark(const render_context* context, VkPipeline vk_pipeline, VkPipeline vk_border_pipeline, VkPipeline vk_fill_pipeline);
+
+// Per-dispatch host overhead of a single-workgroup dispatch, in microseconds per dispatch
+int run_dispatch_benchmark(const render_context* context, VkPipeline vk_pipeline);
+
+// Host time per render of bench_batch_jobs small views along the zoom path, submitted as one batch
+// and with one submission per job, in microseconds per job
+int run_batch_benchmark(const render_context* context);
+
+#ifdef __cplusplus
+}
+#endif
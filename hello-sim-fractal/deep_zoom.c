@@ -0,0 +1,290 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "deep_zoom.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+static int compare_magnitudes(const deep_fixed* a, const deep_fixed* b)
+{
+    for (int i = 0; i < DEEP_LIMBS; i++)
+    {
+        if (a->limbs[i] != b->limbs[i])
+        {
+            return a->limbs[i] < b->limbs[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+static int is_zero(const deep_fixed* value)
+{
+    for (int i = 0; i < DEEP_LIMBS; i++)
+    {
+        if (value->limbs[i] != 0)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// |out| = |a| + |b|, the least significant limb is the last one
+static void add_magnitudes(const deep_fixed* a, const deep_fixed* b, deep_fixed* out)
+{
+    uint64_t carry = 0;
+    for (int i = DEEP_LIMBS - 1; i >= 0; i--)
+    {
+        uint64_t sum = (uint64_t)a->limbs[i] + b->limbs[i] + carry;
+        out->limbs[i] = (uint32_t)sum;
+        carry = sum >> 32;
+    }
+}
+
+// |out| = |a| - |b|, requires |a| >= |b|
+static void sub_magnitudes(const deep_fixed* a, const deep_fixed* b, deep_fixed* out)
+{
+    int64_t borrow = 0;
+    for (int i = DEEP_LIMBS - 1; i >= 0; i--)
+    {
+        int64_t diff = (int64_t)a->limbs[i] - b->limbs[i] - borrow;
+        borrow = diff < 0;
+        out->limbs[i] = (uint32_t)(diff + (borrow << 32));
+    }
+}
+
+static void deep_add(const deep_fixed* a, const deep_fixed* b, deep_fixed* out)
+{
+    deep_fixed result;
+    if (a->negative == b->negative)
+    {
+        add_magnitudes(a, b, &result);
+        result.negative = a->negative;
+    }
+    else if (compare_magnitudes(a, b) >= 0)
+    {
+        sub_magnitudes(a, b, &result);
+        result.negative = a->negative;
+    }
+    else
+    {
+        sub_magnitudes(b, a, &result);
+        result.negative = b->negative;
+    }
+    if (is_zero(&result))
+    {
+        result.negative = 0;
+    }
+    *out = result;
+}
+
+static void deep_sub(const deep_fixed* a, const deep_fixed* b, deep_fixed* out)
+{
+    deep_fixed negated = *b;
+    negated.negative = !negated.negative;
+    deep_add(a, &negated, out);
+}
+
+// Schoolbook product, the limbs below the last fraction limb are truncated
+static void deep_mul(const deep_fixed* a, const deep_fixed* b, deep_fixed* out)
+{
+    // product[k + 1] has the weight 2^(-32 k), like limbs[k]
+    uint32_t product[2 * DEEP_LIMBS];
+    memset(product, 0, sizeof(product));
+
+    for (int i = DEEP_LIMBS - 1; i >= 0; i--)
+    {
+        uint64_t carry = 0;
+        for (int j = DEEP_LIMBS - 1; j >= 0; j--)
+        {
+            uint64_t t = (uint64_t)a->limbs[i] * b->limbs[j] + product[i + j + 1] + carry;
+            product[i + j + 1] = (uint32_t)t;
+            carry = t >> 32;
+        }
+        product[i] = (uint32_t)carry;
+    }
+
+    // product[1] holds the integer part, product[0] would overflow it and stays 0 for orbit values
+    deep_fixed result;
+    memcpy(result.limbs, product + 1, sizeof(result.limbs));
+    result.negative = is_zero(&result) ? 0 : (a->negative != b->negative);
+    *out = result;
+}
+
+void deep_fixed_from_double(double value, deep_fixed* out)
+{
+    memset(out, 0, sizeof(*out));
+    out->negative = value < 0.0;
+
+    double magnitude = fabs(value);
+    double integer = floor(magnitude);
+    out->limbs[0] = (uint32_t)integer;
+
+    // Doubles have 53 significant bits, so this is exact after a couple of limbs
+    double fraction = magnitude - integer;
+    for (int i = 1; i < DEEP_LIMBS && fraction > 0.0; i++)
+    {
+        fraction *= 4294967296.0;
+        double limb = floor(fraction);
+        out->limbs[i] = (uint32_t)limb;
+        fraction -= limb;
+    }
+    if (is_zero(out))
+    {
+        out->negative = 0;
+    }
+}
+
+double deep_fixed_to_double(const deep_fixed* value)
+{
+    double result = 0.0;
+    for (int i = DEEP_LIMBS - 1; i >= 0; i--)
+    {
+        result = result / 4294967296.0 + value->limbs[i];
+    }
+    return value->negative ? -result : result;
+}
+
+int deep_fixed_from_string(const char* text, deep_fixed* out)
+{
+    memset(out, 0, sizeof(*out));
+
+    const char* p = text;
+    int negative = 0;
+    if (*p == '-' || *p == '+')
+    {
+        negative = *p == '-';
+        p++;
+    }
+
+    // Integer part
+    size_t integer_digits = 0;
+    uint64_t integer = 0;
+    while (*p >= '0' && *p <= '9')
+    {
+        integer = integer * 10 + (uint64_t)(*p - '0');
+        integer_digits++;
+        if (integer > UINT32_MAX)
+        {
+            printf("Deep zoom coordinate %s is out of range.\n", text);
+            return -1;
+        }
+        p++;
+    }
+
+    // Fraction digits are folded in from the last one: f = (d + f) / 10
+    const char* fraction = NULL;
+    size_t fraction_digits = 0;
+    if (*p == '.')
+    {
+        fraction = ++p;
+        while (*p >= '0' && *p <= '9')
+        {
+            p++;
+        }
+        fraction_digits = (size_t)(p - fraction);
+    }
+    if (*p != '\0' || integer_digits + fraction_digits == 0)
+    {
+        printf("Deep zoom coordinate %s is not a decimal number.\n", text);
+        return -1;
+    }
+
+    for (size_t k = fraction_digits; k > 0; k--)
+    {
+        out->limbs[0] = (uint32_t)(fraction[k - 1] - '0');
+
+        uint64_t remainder = 0;
+        for (int i = 0; i < DEEP_LIMBS; i++)
+        {
+            uint64_t current = (remainder << 32) | out->limbs[i];
+            out->limbs[i] = (uint32_t)(current / 10);
+            remainder = current % 10;
+        }
+    }
+
+    out->limbs[0] = (uint32_t)integer;
+    out->negative = negative && !is_zero(out);
+    return 0;
+}
+
+int deep_parse_center(const char* real, const char* imag, deep_center* center)
+{
+    if (deep_fixed_from_string(real, &center->real) != 0 ||
+        deep_fixed_from_string(imag, &center->imag) != 0)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+double deep_min_scale(uint32_t width, uint32_t height)
+{
+    uint32_t size = width > height ? width : height;
+    double scale = FLT_MIN * size / 2.0;
+    return scale > DEEP_MIN_SCALE ? scale : DEEP_MIN_SCALE;
+}
+
+size_t deep_orbit_buffer_size(uint32_t max_iterations)
+{
+    // Each orbit holds its starting point and up to max_iterations more
+    return sizeof(deep_orbit_header) + 2 * ((size_t)max_iterations + 1) * 2 * sizeof(float);
+}
+
+// Iterates z = z^2 + c from z until it escapes, storing each point as a float pair
+static uint32_t iterate_orbit(deep_fixed x, deep_fixed y, const deep_fixed* c_real, const deep_fixed* c_imag,
+                              uint32_t max_iterations, float* orbit)
+{
+    uint32_t length = 0;
+    for (;;)
+    {
+        double xd = deep_fixed_to_double(&x);
+        double yd = deep_fixed_to_double(&y);
+        orbit[2 * length + 0] = (float)xd;
+        orbit[2 * length + 1] = (float)yd;
+        length++;
+
+        // Keep the first escaping point, a pixel following the orbit escapes right after it
+        if (xd * xd + yd * yd >= 4.0 || length > max_iterations)
+        {
+            break;
+        }
+
+        deep_fixed x2, y2, xy;
+        deep_mul(&x, &x, &x2);
+        deep_mul(&y, &y, &y2);
+        deep_mul(&x, &y, &xy);
+
+        deep_sub(&x2, &y2, &x);
+        deep_add(&x, c_real, &x);
+        deep_add(&xy, &xy, &y);
+        deep_add(&y, c_imag, &y);
+    }
+    return length;
+}
+
+deep_orbit_header deep_build_orbits(const deep_center* center, const fractal_params* params, uint32_t max_iterations, void* buffer)
+{
+    deep_fixed c_real, c_imag, zero;
+    deep_fixed_from_double(params->c_real, &c_real);
+    deep_fixed_from_double(params->c_imag, &c_imag);
+    deep_fixed_from_double(0.0, &zero);
+
+    deep_orbit_header header;
+    float* orbit = (float*)((char*)buffer + sizeof(deep_orbit_header));
+
+    // Pixels are perturbations of the center orbit, and rebase onto the critical orbit
+    // when they get closer to 0 than to the reference
+    header.reference_length = iterate_orbit(center->real, center->imag, &c_real, &c_imag, max_iterations, orbit);
+    header.critical_length = iterate_orbit(zero, zero, &c_real, &c_imag, max_iterations, orbit + 2 * header.reference_length);
+
+    memcpy(buffer, &header, sizeof(header));
+    return header;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,55 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "fractal_params.h"
+
+// Fraction limbs of the fixed-point numbers, 32 bits each (160 bits, about 48 decimal digits)
+#define DEEP_FRACTION_LIMBS 5
+#define DEEP_LIMBS (1 + DEEP_FRACTION_LIMBS)
+
+// Smallest view scale, the per-pixel offsets are floats. The step between pixels, 2 * scale / size,
+// must stay a normal float, or GPUs that flush denormals merge the pixels around the center.
+#define DEEP_MIN_SCALE 1e-30
+
+// Sign-magnitude fixed-point number, limbs[0] is the integer part and limbs[1..] the fraction
+typedef struct deep_fixed {
+    int negative;
+    uint32_t limbs[DEEP_LIMBS];
+} deep_fixed;
+
+// High-precision center of a deep zoom, the pixels are float offsets from it
+typedef struct deep_center {
+    deep_fixed real;
+    deep_fixed imag;
+} deep_center;
+
+// Layout of the orbit buffer read by shader/fractal_deep.comp: the header, the reference orbit
+// of the center, then the orbit of the critical point 0. Both end with their first escaping point.
+typedef struct deep_orbit_header {
+    uint32_t reference_length;
+    uint32_t critical_length;
+} deep_orbit_header;
+
+void deep_fixed_from_double(double value, deep_fixed* out);
+double deep_fixed_to_double(const deep_fixed* value);
+// Parses a plain decimal number such as "-0.74364388703715870475", returns -1 if it isn't one
+int deep_fixed_from_string(const char* text, deep_fixed* out);
+
+int deep_parse_center(const char* real, const char* imag, deep_center* center);
+
+// Smallest scale of a width x height view, DEEP_MIN_SCALE or more for images so large that its pixel step would be denormal
+double deep_min_scale(uint32_t width, uint32_t height);
+
+// Size of an orbit buffer holding orbits of up to max_iterations iterations
+size_t deep_orbit_buffer_size(uint32_t max_iterations);
+// Iterates both orbits in fixed point and writes them as floats, returns the header it wrote
+deep_orbit_header deep_build_orbits(const deep_center* center, const fractal_params* params, uint32_t max_iterations, void* buffer);
+
+#ifdef __cplusplus
+}
+#endif
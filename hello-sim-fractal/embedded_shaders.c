@@ -0,0 +1,52 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "embedded_shaders.h"
+#include "vkrt/spirv.h"
+
+#ifdef FRACTAL_EMBED_SHADERS
+// Generated at build time by glslc -mfmt=c, see CMakeLists.txt
+static const uint32_t fractal_spv[] =
+#include "shader/fractal.spv.inc"
+;
+static const uint32_t fractal_deep_spv[] =
+#include "shader/fractal_deep.spv.inc"
+;
+static const uint32_t fractal_adaptive_border_spv[] =
+#include "shader/fractal_adaptive_border.spv.inc"
+;
+static const uint32_t fractal_adaptive_fill_spv[] =
+#include "shader/fractal_adaptive_fill.spv.inc"
+;
+static const uint32_t fractal_equalize_histogram_spv[] =
+#include "shader/fractal_equalize_histogram.spv.inc"
+;
+static const uint32_t fractal_equalize_scan_spv[] =
+#include "shader/fractal_equalize_scan.spv.inc"
+;
+static const uint32_t fractal_equalize_colorize_spv[] =
+#include "shader/fractal_equalize_colorize.spv.inc"
+;
+
+static const spirv_embedded_shader embedded_shaders[] = {
+    { "shader/fractal.spv", fractal_spv, sizeof(fractal_spv) },
+    { "shader/fractal_deep.spv", fractal_deep_spv, sizeof(fractal_deep_spv) },
+    { "shader/fractal_adaptive_border.spv", fractal_adaptive_border_spv, sizeof(fractal_adaptive_border_spv) },
+    { "shader/fractal_adaptive_fill.spv", fractal_adaptive_fill_spv, sizeof(fractal_adaptive_fill_spv) },
+    { "shader/fractal_equalize_histogram.spv", fractal_equalize_histogram_spv, sizeof(fractal_equalize_histogram_spv) },
+    { "shader/fractal_equalize_scan.spv", fractal_equalize_scan_spv, sizeof(fractal_equalize_scan_spv) },
+    { "shader/fractal_equalize_colorize.spv", fractal_equalize_colorize_spv, sizeof(fractal_equalize_colorize_spv) },
+};
+#endif
+
+void register_embedded_shaders(void)
+{
+#ifdef FRACTAL_EMBED_SHADERS
+    spirv_set_embedded_shaders(embedded_shaders, sizeof(embedded_shaders) / sizeof(embedded_shaders[0]));
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,13 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Registers the shaders compiled into the executable with spirv_load, does nothing unless
+// the build embeds shaders
+void register_embedded_shaders(void);
+
+#ifdef __cplusplus
+}
+#endif
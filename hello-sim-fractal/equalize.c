@@ -0,0 +1,151 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "equalize.h"
+#include "vkrt/compute.h"
+#include <stdio.h>
+#include <string.h>
+
+VkDeviceSize vk_equalize_buffer_size(uint32_t iterations)
+{
+    return 2 * ((VkDeviceSize)iterations + 1) * sizeof(uint32_t);
+}
+
+int vk_check_equalize(VkPhysicalDevice vk_phy_device, const vk_tile_plan* plan)
+{
+    // The passes read one count per uint
+    if (plan->output != FRACTAL_OUTPUT_PACKED)
+    {
+        printf("Equalized coloring starts from the packed GPU output, it writes RGBA itself.\n");
+        return -1;
+    }
+
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(vk_phy_device, &deviceProperties);
+    if (deviceProperties.apiVersion < VK_API_VERSION_1_1)
+    {
+        printf("Equalized coloring needs subgroup operations from Vulkan 1.1.\n");
+        return -1;
+    }
+
+    VkPhysicalDeviceSubgroupProperties subgroupProperties;
+    memset(&subgroupProperties, 0, sizeof(subgroupProperties));
+    subgroupProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+
+    VkPhysicalDeviceProperties2 properties2;
+    memset(&properties2, 0, sizeof(properties2));
+    properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties2.pNext = &subgroupProperties;
+    vkGetPhysicalDeviceProperties2(vk_phy_device, &properties2);
+
+    VkSubgroupFeatureFlags needed = VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_VOTE_BIT | VK_SUBGROUP_FEATURE_ARITHMETIC_BIT;
+    if ((subgroupProperties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) == 0 ||
+        (subgroupProperties.supportedOperations & needed) != needed)
+    {
+        printf("Equalized coloring needs subgroup vote and arithmetic in compute shaders.\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Makes the writes of one pass visible to the next
+static void record_compute_barrier(VkCommandBuffer vk_command_buffer, VkAccessFlags src_access, VkPipelineStageFlags src_stage)
+{
+    VkMemoryBarrier memoryBarrier;
+    memset(&memoryBarrier, 0, sizeof(memoryBarrier));
+    memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memoryBarrier.srcAccessMask = src_access;
+    memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(vk_command_buffer, src_stage, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                         1, &memoryBarrier, 0, NULL, 0, NULL);
+}
+
+void vk_record_equalized_tile(
+    VkCommandBuffer vk_command_buffer,
+    const vk_equalize_pipelines* pipelines,
+    VkPipelineLayout vk_pipeline_layout,
+    VkDescriptorSet vk_descriptor_set,
+    const vk_tile_plan* plan,
+    const vk_tile_push_constants* tile,
+    uint32_t tile_index,
+    VkBuffer vk_equalize_buffer,
+    VkQueryPool vk_query_pool,
+    uint32_t vk_query_index,
+    VkBuffer vk_output_buffer,
+    VkBuffer vk_staging_buffer,
+    VkDeviceSize readback_size)
+{
+    uint32_t tile_count = vk_tile_count(plan);
+    uint32_t group_count_x = vk_tile_group_count_x(plan, tile->tile_width);
+
+    if (vk_query_pool != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(vk_command_buffer, vk_query_pool, vk_query_index, 2);
+        vkCmdWriteTimestamp(vk_command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, vk_query_pool, vk_query_index);
+    }
+
+    // The first tile starts an empty histogram. The barrier also orders the shaders after a copy of
+    // the previous submission still reading the output buffer.
+    if (tile_index == 0)
+    {
+        vkCmdFillBuffer(vk_command_buffer, vk_equalize_buffer, 0, (VkDeviceSize)(tile->iterations + 1) * sizeof(uint32_t), 0);
+    }
+    record_compute_barrier(vk_command_buffer, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+    vkCmdBindDescriptorSets(vk_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, vk_pipeline_layout,
+                            0, 1, &vk_descriptor_set, 0, NULL);
+    vkCmdPushConstants(vk_command_buffer, vk_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(*tile), tile);
+
+    vkCmdBindPipeline(vk_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelines->fractal);
+    vkCmdDispatch(vk_command_buffer, group_count_x, tile->tile_height, 1);
+
+    record_compute_barrier(vk_command_buffer, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    vkCmdBindPipeline(vk_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelines->histogram);
+    vkCmdDispatch(vk_command_buffer, group_count_x, tile->tile_height, 1);
+
+    if (tile_index + 1 == tile_count)
+    {
+        record_compute_barrier(vk_command_buffer, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+        vkCmdBindPipeline(vk_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelines->scan);
+        vkCmdDispatch(vk_command_buffer, 1, 1, 1);
+
+        if (tile_count == 1)
+        {
+            record_compute_barrier(vk_command_buffer, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+            vkCmdBindPipeline(vk_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelines->colorize);
+            vkCmdDispatch(vk_command_buffer, group_count_x, tile->tile_height, 1);
+        }
+    }
+
+    if (vk_query_pool != VK_NULL_HANDLE)
+    {
+        vkCmdWriteTimestamp(vk_command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, vk_query_pool, vk_query_index + 1);
+    }
+
+    // The host reads the equalized palette when it colors the image itself
+    VkMemoryBarrier memoryBarrier;
+    memset(&memoryBarrier, 0, sizeof(memoryBarrier));
+    memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(vk_command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+                         1, &memoryBarrier, 0, NULL, 0, NULL);
+
+    vk_record_output_barrier(vk_command_buffer, vk_output_buffer, vk_staging_buffer, readback_size);
+}
+
+void equalize_colorize_image(uint32_t* pixels, size_t count, const uint32_t* equalize_buffer, uint32_t iterations)
+{
+    uint32_t bin_count = iterations + 1;
+    const uint32_t* palette = equalize_buffer + bin_count;
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t cnt = (pixels[i] & 0x00ffffff) >> 2;
+        pixels[i] = palette[cnt < bin_count ? cnt : bin_count - 1];
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
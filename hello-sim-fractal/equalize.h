@@ -0,0 +1,51 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <vulkan/vulkan.h>
+#include "tile.h"
+
+// Pipelines of an equalized render, all sharing the layout and descriptor set of fractal.comp
+typedef struct vk_equalize_pipelines {
+    VkPipeline fractal;         // fractal.comp with packed output
+    VkPipeline histogram;       // shader/fractal_equalize_histogram.comp
+    VkPipeline scan;            // shader/fractal_equalize_scan.comp
+    VkPipeline colorize;        // shader/fractal_equalize_colorize.comp
+} vk_equalize_pipelines;
+
+// Bytes of the histogram and the equalized palette behind it, for counts up to iterations
+VkDeviceSize vk_equalize_buffer_size(uint32_t iterations);
+// Returns -1 and prints why if the plan can't be colored by equalization on this device
+int vk_check_equalize(VkPhysicalDevice vk_phy_device, const vk_tile_plan* plan);
+
+// Records one tile of an equalized render: the fractal dispatch, then the histogram pass adding the
+// tile's counts to the histogram in the equalize buffer. The first tile clears the histogram. The last
+// tile also scans it into the equalized palette, and when the image is a single tile colors the output
+// through the palette before the readback. The equalize buffer needs transfer destination usage, its
+// palette is host-readable after the last tile. Timestamps and the readback work as in vk_record_dispatch.
+void vk_record_equalized_tile(
+    VkCommandBuffer vk_command_buffer,
+    const vk_equalize_pipelines* pipelines,
+    VkPipelineLayout vk_pipeline_layout,
+    VkDescriptorSet vk_descriptor_set,      // The equalize buffer is bound as the input buffer
+    const vk_tile_plan* plan,
+    const vk_tile_push_constants* tile,
+    uint32_t tile_index,
+    VkBuffer vk_equalize_buffer,
+    VkQueryPool vk_query_pool,
+    uint32_t vk_query_index,
+    VkBuffer vk_output_buffer,
+    VkBuffer vk_staging_buffer,             // VK_NULL_HANDLE when the output buffer is read directly
+    VkDeviceSize readback_size
+);
+
+// Colors an image of packed counts on the host, for images of several tiles: the GPU only colors
+// a tile while it is in the output buffer, and every tile but the last was read back before the scan
+void equalize_colorize_image(uint32_t* pixels, size_t count, const uint32_t* equalize_buffer, uint32_t iterations);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,268 @@
+#include "export.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stb_image_write.h>
+
+#include <stdio.h>
+#include <string.h>
+
+int export_format_from_string(const char* name, export_format* format)
+{
+    if (strcmp(name, "png") == 0)
+    {
+        *format = EXPORT_FORMAT_PNG;
+    }
+    else if (strcmp(name, "raw") == 0)
+    {
+        *format = EXPORT_FORMAT_RAW;
+    }
+    else
+    {
+        return -1;
+    }
+    return 0;
+}
+
+const char* export_format_extension(export_format format, export_pixels pixels)
+{
+    if (format == EXPORT_FORMAT_RAW)
+    {
+        return pixels == EXPORT_PIXELS_GRAY8 ? "gray" : "rgba";
+    }
+    return "png";
+}
+
+uint32_t export_pixel_bytes(export_pixels pixels)
+{
+    return pixels == EXPORT_PIXELS_GRAY8 ? 1 : 4;
+}
+
+void export_convert_rgba(const uint32_t* pixels, size_t count, unsigned char* rgba)
+{
+    const uint16_t probe = 1;
+    if (*(const unsigned char*)&probe == 1)
+    {
+        // On little-endian hosts this is a swap of the red and blue bytes, which vectorizes
+        for (size_t i = 0; i < count; i++)
+        {
+            uint32_t color = pixels[i];
+            uint32_t swapped = (color & 0xFF00FF00u) | ((color >> 16) & 0xFFu) | ((color & 0xFFu) << 16);
+            memcpy(rgba + i * 4, &swapped, sizeof(swapped));
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t color = pixels[i];
+        rgba[i * 4 + 0] = (color >> 16) & 0xFF;  // Red
+        rgba[i * 4 + 1] = (color >> 8) & 0xFF;   // Green
+        rgba[i * 4 + 2] = color & 0xFF;          // Blue
+        rgba[i * 4 + 3] = (color >> 24) & 0xFF;  // Alpha
+    }
+}
+
+void export_build_palette(uint32_t entries, unsigned char* rgba)
+{
+    for (uint32_t n = 0; n < entries; n++)
+    {
+        uint32_t color = (n << 2) | 0xff000000;
+        export_convert_rgba(&color, 1, rgba + (size_t)n * 4);
+    }
+}
+
+// Writes pixels, packed ones are converted through a caller-provided buffer of width * height * 4 bytes
+static int write_image(const char* filename, const void* pixels, uint32_t width, uint32_t height, export_pixels layout,
+                       export_format format, unsigned char* rgba)
+{
+    size_t count = (size_t)width * height;
+    const unsigned char* data = (const unsigned char*)pixels;
+    if (layout == EXPORT_PIXELS_PACKED)
+    {
+        export_convert_rgba((const uint32_t*)pixels, count, rgba);
+        data = rgba;
+    }
+    int channels = (int)export_pixel_bytes(layout);
+
+    if (format == EXPORT_FORMAT_RAW)
+    {
+        FILE* file = fopen(filename, "wb");
+        if (file == NULL)
+        {
+            printf("Failed to open %s.\n", filename);
+            return -1;
+        }
+        size_t written = fwrite(data, channels, count, file);
+        if (fclose(file) != 0 || written != count)
+        {
+            printf("Failed to write %s.\n", filename);
+            return -1;
+        }
+        return 0;
+    }
+
+    if (!stbi_write_png(filename, width, height, channels, data, width * channels))
+    {
+        printf("Failed to write %s.\n", filename);
+        return -1;
+    }
+    return 0;
+}
+
+int export_write_image(const char* filename, const void* pixels, uint32_t width, uint32_t height, export_pixels layout, export_format format)
+{
+    std::vector<unsigned char> rgba(layout == EXPORT_PIXELS_PACKED ? (size_t)width * height * 4 : 0);
+    return write_image(filename, pixels, width, height, layout, format, rgba.data());
+}
+
+struct frame_exporter
+{
+    struct Job
+    {
+        void* frame;
+        std::string filename;
+    };
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    export_pixels layout = EXPORT_PIXELS_PACKED;
+    export_format format = EXPORT_FORMAT_PNG;
+
+    std::vector<std::vector<unsigned char>> buffers;
+    std::vector<void*> free_buffers;
+    std::deque<Job> jobs;
+    uint32_t writing = 0;
+    bool failed = false;
+    bool stopping = false;
+    double stall_time = 0.0;
+
+    std::mutex mutex;
+    std::condition_variable job_ready;      // Workers wait for jobs
+    std::condition_variable buffer_free;    // The renderer waits for buffers, exporter_finish for the queue to drain
+    std::vector<std::thread> workers;
+
+    void worker_loop()
+    {
+        // Each worker converts packed frames into its own RGBA buffer
+        std::vector<unsigned char> rgba(layout == EXPORT_PIXELS_PACKED ? (size_t)width * height * 4 : 0);
+
+        for (;;)
+        {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                job_ready.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (jobs.empty())
+                {
+                    return;
+                }
+                job = std::move(jobs.front());
+                jobs.pop_front();
+                writing++;
+            }
+
+            int result = write_image(job.filename.c_str(), job.frame, width, height, layout, format, rgba.data());
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                failed = failed || result != 0;
+                free_buffers.push_back(job.frame);
+                writing--;
+            }
+            buffer_free.notify_all();
+        }
+    }
+};
+
+frame_exporter* exporter_create(uint32_t width, uint32_t height, export_pixels layout, export_format format,
+                                uint32_t worker_count, uint32_t buffer_count)
+{
+    if (worker_count == 0)
+    {
+        // Leave a core for the thread feeding the GPU
+        uint32_t cores = std::thread::hardware_concurrency();
+        worker_count = cores > 1 ? cores - 1 : 1;
+    }
+    if (buffer_count == 0)
+    {
+        // Two spare frame buffers let the renderer run ahead while every worker is busy
+        buffer_count = worker_count + 2;
+    }
+
+    frame_exporter* exporter = new frame_exporter();
+    exporter->width = width;
+    exporter->height = height;
+    exporter->layout = layout;
+    exporter->format = format;
+
+    exporter->buffers.resize(buffer_count);
+    for (std::vector<unsigned char>& buffer : exporter->buffers)
+    {
+        buffer.resize((size_t)width * height * export_pixel_bytes(layout));
+        exporter->free_buffers.push_back(buffer.data());
+    }
+
+    for (uint32_t i = 0; i < worker_count; i++)
+    {
+        exporter->workers.emplace_back([exporter] { exporter->worker_loop(); });
+    }
+    return exporter;
+}
+
+void* exporter_acquire(frame_exporter* exporter)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(exporter->mutex);
+    exporter->buffer_free.wait(lock, [exporter] { return !exporter->free_buffers.empty(); });
+
+    void* frame = exporter->free_buffers.back();
+    exporter->free_buffers.pop_back();
+
+    exporter->stall_time += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    return frame;
+}
+
+void exporter_submit(frame_exporter* exporter, void* frame, const char* filename)
+{
+    {
+        std::lock_guard<std::mutex> lock(exporter->mutex);
+        exporter->jobs.push_back({ frame, filename });
+    }
+    exporter->job_ready.notify_one();
+}
+
+int exporter_finish(frame_exporter* exporter)
+{
+    std::unique_lock<std::mutex> lock(exporter->mutex);
+    exporter->buffer_free.wait(lock, [exporter] { return exporter->jobs.empty() && exporter->writing == 0; });
+    return exporter->failed ? -1 : 0;
+}
+
+double exporter_stall_time(const frame_exporter* exporter)
+{
+    return exporter->stall_time;
+}
+
+void exporter_destroy(frame_exporter* exporter)
+{
+    {
+        std::lock_guard<std::mutex> lock(exporter->mutex);
+        exporter->stopping = true;
+    }
+    exporter->job_ready.notify_all();
+
+    // Workers drain the queue before they exit
+    for (std::thread& worker : exporter->workers)
+    {
+        worker.join();
+    }
+    delete exporter;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum export_format {
+    EXPORT_FORMAT_PNG = 0,
+    EXPORT_FORMAT_RAW       // Headerless pixels, RGBA8 or 8-bit gray
+} export_format;
+
+// Layout of the pixels handed to the exporter
+typedef enum export_pixels {
+    EXPORT_PIXELS_PACKED = 0,   // 0xAARRGGBB uints, converted to RGBA8 on the way out
+    EXPORT_PIXELS_RGBA8,        // Written as they are
+    EXPORT_PIXELS_GRAY8         // One byte per pixel, written as they are
+} export_pixels;
+
+// Parses png or raw, returns -1 for any other name
+int export_format_from_string(const char* name, export_format* format);
+const char* export_format_extension(export_format format, export_pixels pixels);
+uint32_t export_pixel_bytes(export_pixels pixels);
+
+// Converts packed 0xAARRGGBB pixels to RGBA8 bytes
+void export_convert_rgba(const uint32_t* pixels, size_t count, unsigned char* rgba);
+
+// Fills entries RGBA8 colors, entry n is the color the packed format gives n iterations
+void export_build_palette(uint32_t entries, unsigned char* rgba);
+
+// Converts and writes one image synchronously
+int export_write_image(const char* filename, const void* pixels, uint32_t width, uint32_t height, export_pixels layout, export_format format);
+
+// Encodes and writes frames on worker threads. The caller renders into frame buffers taken from
+// a fixed pool, so rendering only stalls when every buffer is still waiting to be written.
+typedef struct frame_exporter frame_exporter;
+
+// worker_count 0 uses all cores but one, buffer_count 0 gives two buffers more than workers
+frame_exporter* exporter_create(uint32_t width, uint32_t height, export_pixels layout, export_format format,
+                                uint32_t worker_count, uint32_t buffer_count);
+// Blocks until a frame buffer is free
+void* exporter_acquire(frame_exporter* exporter);
+// Queues a frame taken from exporter_acquire, the buffer returns to the pool once it is written
+void exporter_submit(frame_exporter* exporter, void* frame, const char* filename);
+// Waits for every queued frame, returns -1 if any of them failed to write
+int exporter_finish(frame_exporter* exporter);
+// Time the caller spent blocked in exporter_acquire, in microseconds
+double exporter_stall_time(const frame_exporter* exporter);
+void exporter_destroy(frame_exporter* exporter);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,671 @@
+#include "fractal_cpu.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define FRACTAL_CPU_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang need the target ISA per function, MSVC accepts the intrinsics as is.
+// Note: the kernels rely on mul/add not being fused, build this file with -ffp-contract=off.
+#if defined(__GNUC__) || defined(__clang__)
+#define FRACTAL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define FRACTAL_TARGET(isa)
+#endif
+
+// Same arithmetic as the original scalar loop: float products, double constants.
+static inline uint32_t escape_scalar(float r, float i, const fractal_params* params)
+{
+    uint32_t cnt = 0;
+    while (((r * r + i * i) < 4.0) && (cnt < params->max_iterations))
+    {
+        float temp = r * r - i * i + params->c_real;
+        i = 2 * r * i + params->c_imag;
+        r = temp;
+        cnt++;
+    }
+    return (cnt << 10) | 0xff000000;
+}
+
+static void row_scalar(uint32_t* out, const float* r0, const float* i0, uint32_t width, const fractal_params* params)
+{
+    for (uint32_t col = 0; col < width; col++)
+    {
+        out[col] = escape_scalar(r0[col], i0[col], params);
+    }
+}
+
+#ifdef FRACTAL_CPU_X86
+
+// float + double constant, rounded back to float, exactly like the scalar promotion rules
+FRACTAL_TARGET("sse2")
+static inline __m128 add_double_sse2(__m128 a, __m128d c)
+{
+    __m128d lo = _mm_add_pd(_mm_cvtps_pd(a), c);
+    __m128d hi = _mm_add_pd(_mm_cvtps_pd(_mm_movehl_ps(a, a)), c);
+    return _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi));
+}
+
+FRACTAL_TARGET("sse2")
+static void row_sse2(uint32_t* out, const float* r0, const float* i0, uint32_t width, const fractal_params* params)
+{
+    const __m128 four = _mm_set1_ps(4.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128d cr = _mm_set1_pd(params->c_real);
+    const __m128d ci = _mm_set1_pd(params->c_imag);
+    const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+
+    uint32_t col = 0;
+    for (; col + 4 <= width; col += 4)
+    {
+        __m128 r = _mm_loadu_ps(r0 + col);
+        __m128 i = _mm_loadu_ps(i0 + col);
+        __m128i active = _mm_set1_epi32(-1);
+        __m128i cnt = _mm_setzero_si128();
+
+        for (uint32_t k = 0; k < params->max_iterations; k++)
+        {
+            __m128 rr = _mm_mul_ps(r, r);
+            __m128 ii = _mm_mul_ps(i, i);
+
+            // A lane stays escaped once it has escaped
+            active = _mm_and_si128(active, _mm_castps_si128(_mm_cmplt_ps(_mm_add_ps(rr, ii), four)));
+            if (_mm_movemask_ps(_mm_castsi128_ps(active)) == 0)
+            {
+                break;
+            }
+            cnt = _mm_sub_epi32(cnt, active);
+
+            __m128 temp = add_double_sse2(_mm_sub_ps(rr, ii), cr);
+            i = add_double_sse2(_mm_mul_ps(_mm_mul_ps(two, r), i), ci);
+            r = temp;
+        }
+        _mm_storeu_si128((__m128i*)(out + col), _mm_or_si128(_mm_slli_epi32(cnt, 10), alpha));
+    }
+    row_scalar(out + col, r0 + col, i0 + col, width - col, params);
+}
+
+FRACTAL_TARGET("avx2")
+static inline __m256 add_double_avx2(__m256 a, __m256d c)
+{
+    __m256d lo = _mm256_add_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(a)), c);
+    __m256d hi = _mm256_add_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(a, 1)), c);
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(lo)), _mm256_cvtpd_ps(hi), 1);
+}
+
+FRACTAL_TARGET("avx2")
+static void row_avx2(uint32_t* out, const float* r0, const float* i0, uint32_t width, const fractal_params* params)
+{
+    const __m256 four = _mm256_set1_ps(4.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+    const __m256d cr = _mm256_set1_pd(params->c_real);
+    const __m256d ci = _mm256_set1_pd(params->c_imag);
+    const __m256i alpha = _mm256_set1_epi32((int)0xff000000);
+
+    uint32_t col = 0;
+    for (; col + 8 <= width; col += 8)
+    {
+        __m256 r = _mm256_loadu_ps(r0 + col);
+        __m256 i = _mm256_loadu_ps(i0 + col);
+        __m256i active = _mm256_set1_epi32(-1);
+        __m256i cnt = _mm256_setzero_si256();
+
+        for (uint32_t k = 0; k < params->max_iterations; k++)
+        {
+            __m256 rr = _mm256_mul_ps(r, r);
+            __m256 ii = _mm256_mul_ps(i, i);
+
+            active = _mm256_and_si256(active, _mm256_castps_si256(_mm256_cmp_ps(_mm256_add_ps(rr, ii), four, _CMP_LT_OQ)));
+            if (_mm256_testz_si256(active, active))
+            {
+                break;
+            }
+            cnt = _mm256_sub_epi32(cnt, active);
+
+            __m256 temp = add_double_avx2(_mm256_sub_ps(rr, ii), cr);
+            i = add_double_avx2(_mm256_mul_ps(_mm256_mul_ps(two, r), i), ci);
+            r = temp;
+        }
+        _mm256_storeu_si256((__m256i*)(out + col), _mm256_or_si256(_mm256_slli_epi32(cnt, 10), alpha));
+    }
+    row_scalar(out + col, r0 + col, i0 + col, width - col, params);
+}
+
+FRACTAL_TARGET("avx512f")
+static inline __m512 add_double_avx512(__m512 a, __m512d c)
+{
+    __m512d lo = _mm512_add_pd(_mm512_cvtps_pd(_mm512_castps512_ps256(a)), c);
+    __m512d hi = _mm512_add_pd(_mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(a), 1))), c);
+    __m512d packed = _mm512_insertf64x4(_mm512_castpd256_pd512(_mm256_castps_pd(_mm512_cvtpd_ps(lo))),
+                                        _mm256_castps_pd(_mm512_cvtpd_ps(hi)), 1);
+    return _mm512_castpd_ps(packed);
+}
+
+FRACTAL_TARGET("avx512f")
+static void row_avx512(uint32_t* out, const float* r0, const float* i0, uint32_t width, const fractal_params* params)
+{
+    const __m512 four = _mm512_set1_ps(4.0f);
+    const __m512 two = _mm512_set1_ps(2.0f);
+    const __m512d cr = _mm512_set1_pd(params->c_real);
+    const __m512d ci = _mm512_set1_pd(params->c_imag);
+    const __m512i one = _mm512_set1_epi32(1);
+    const __m512i alpha = _mm512_set1_epi32((int)0xff000000);
+
+    for (uint32_t col = 0; col < width; col += 16)
+    {
+        // The last block of the row only loads and stores the lanes inside the image
+        uint32_t lanes = width - col < 16 ? width - col : 16;
+        __mmask16 valid = (__mmask16)((1u << lanes) - 1u);
+
+        __m512 r = _mm512_maskz_loadu_ps(valid, r0 + col);
+        __m512 i = _mm512_maskz_loadu_ps(valid, i0 + col);
+        __mmask16 active = valid;
+        __m512i cnt = _mm512_setzero_si512();
+
+        for (uint32_t k = 0; k < params->max_iterations; k++)
+        {
+            __m512 rr = _mm512_mul_ps(r, r);
+            __m512 ii = _mm512_mul_ps(i, i);
+
+            active = _mm512_mask_cmp_ps_mask(active, _mm512_add_ps(rr, ii), four, _CMP_LT_OQ);
+            if (active == 0)
+            {
+                break;
+            }
+            cnt = _mm512_mask_add_epi32(cnt, active, cnt, one);
+
+            __m512 temp = add_double_avx512(_mm512_sub_ps(rr, ii), cr);
+            i = add_double_avx512(_mm512_mul_ps(_mm512_mul_ps(two, r), i), ci);
+            r = temp;
+        }
+        _mm512_mask_storeu_epi32(out + col, valid, _mm512_or_si512(_mm512_slli_epi32(cnt, 10), alpha));
+    }
+}
+
+#if defined(_MSC_VER) && !defined(__clang__)
+static bool os_supports_xsave_state(unsigned long long mask)
+{
+    int info[4];
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0)
+    {
+        return false;
+    }
+    return (_xgetbv(0) & mask) == mask;
+}
+#endif
+
+#endif // FRACTAL_CPU_X86
+
+static cpu_simd_level detect_simd_level(void)
+{
+#if defined(FRACTAL_CPU_X86) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return CPU_SIMD_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return CPU_SIMD_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+        return CPU_SIMD_SSE2;
+    }
+#elif defined(FRACTAL_CPU_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, 7, 0);
+    bool avx2 = (info[1] & (1 << 5)) != 0;
+    bool avx512f = (info[1] & (1 << 16)) != 0;
+
+    // AVX-512 needs the OS to save opmask and ZMM state, AVX2 the YMM state
+    if (avx512f && os_supports_xsave_state(0xe6))
+    {
+        return CPU_SIMD_AVX512;
+    }
+    if (avx2 && os_supports_xsave_state(0x06))
+    {
+        return CPU_SIMD_AVX2;
+    }
+    __cpuid(info, 1);
+    if (info[3] & (1 << 26))
+    {
+        return CPU_SIMD_SSE2;
+    }
+#endif
+    return CPU_SIMD_SCALAR;
+}
+
+cpu_simd_level cpu_detect_simd_level(void)
+{
+    static const cpu_simd_level level = detect_simd_level();
+    return level;
+}
+
+int cpu_simd_level_from_string(const char* name, cpu_simd_level* level)
+{
+    for (int l = CPU_SIMD_SCALAR; l <= CPU_SIMD_AUTO; l++)
+    {
+        if (strcmp(name, cpu_simd_level_as_string((cpu_simd_level)l)) == 0)
+        {
+            *level = (cpu_simd_level)l;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char* cpu_simd_level_as_string(cpu_simd_level level)
+{
+    switch (level)
+    {
+    case CPU_SIMD_SCALAR:
+        return "scalar";
+
+    case CPU_SIMD_SSE2:
+        return "sse2";
+
+    case CPU_SIMD_AVX2:
+        return "avx2";
+
+    case CPU_SIMD_AVX512:
+        return "avx512";
+
+    default:
+        return "auto";
+    }
+}
+
+// Renders width points given by their real and imaginary parts, a row of the image or a column of a rectangle
+typedef void (*row_kernel_fn)(uint32_t* out, const float* r0, const float* i0, uint32_t width, const fractal_params* params);
+
+static row_kernel_fn select_row_kernel(cpu_simd_level level)
+{
+    // Never pick an instruction set the CPU doesn't have
+    if (level == CPU_SIMD_AUTO || level > cpu_detect_simd_level())
+    {
+        level = cpu_detect_simd_level();
+    }
+
+#ifdef FRACTAL_CPU_X86
+    switch (level)
+    {
+    case CPU_SIMD_SSE2:
+        return row_sse2;
+
+    case CPU_SIMD_AVX2:
+        return row_avx2;
+
+    case CPU_SIMD_AVX512:
+        return row_avx512;
+
+    default:
+        break;
+    }
+#endif
+    return row_scalar;
+}
+
+// Blocks an adaptive render starts from, and the size below which a mixed rectangle is iterated in full
+#define CPU_ADAPTIVE_BLOCK_SIZE 64u
+#define CPU_ADAPTIVE_MIN_SIZE 8u
+
+// The imaginary part only depends on the column
+static std::vector<float> column_table(uint32_t width, const fractal_params* params)
+{
+    std::vector<float> i0(width);
+    for (uint32_t col = 0; col < width; col++)
+    {
+        i0[col] = params->center_imag + params->scale * ((float)col / (width / 2.0) - 1.0);
+    }
+    return i0;
+}
+
+// The real part only depends on the row
+static std::vector<float> row_table(uint32_t height, const fractal_params* params)
+{
+    std::vector<float> r0(height);
+    for (uint32_t row = 0; row < height; row++)
+    {
+        r0[row] = params->center_real + params->scale * ((float)row / (height / 2.0) - 1.0);
+    }
+    return r0;
+}
+
+static void render_rows(uint32_t* out, uint32_t width, uint32_t row_begin, uint32_t row_end,
+                        const fractal_params* params, row_kernel_fn row_kernel, const float* r0, const float* i0)
+{
+    std::vector<float> r(width);
+    for (uint32_t row = row_begin; row < row_end; row++)
+    {
+        std::fill(r.begin(), r.end(), r0[row]);
+        row_kernel(out + (size_t)row * width, r.data(), i0, width, params);
+    }
+}
+
+void cpu_generate_fractal_rows(
+    uint32_t* out,
+    uint32_t width,
+    uint32_t height,
+    uint32_t row_begin,
+    uint32_t row_end,
+    const fractal_params* params,
+    cpu_simd_level level)
+{
+    std::vector<float> r0 = row_table(height, params);
+    std::vector<float> i0 = column_table(width, params);
+    render_rows(out, width, row_begin, row_end, params, select_row_kernel(level), r0.data(), i0.data());
+}
+
+namespace {
+
+// Fixed set of workers that split [0, rows) into small chunks handed out via an atomic counter
+class RowThreadPool {
+public:
+    explicit RowThreadPool(uint32_t thread_count)
+    {
+        for (uint32_t t = 1; t < thread_count; t++)
+        {
+            workers.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    ~RowThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    uint32_t size() const
+    {
+        return (uint32_t)workers.size() + 1;
+    }
+
+    // Blocks until all rows are done, the calling thread works too
+    void run(uint32_t rows, uint32_t rows_per_task, const std::function<void(uint32_t, uint32_t)>& fn)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &fn;
+            job_rows = rows;
+            job_chunk = rows_per_task;
+            next_row = 0;
+            busy = (uint32_t)workers.size();
+            generation++;
+        }
+        wake.notify_all();
+
+        drain();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return busy == 0; });
+        job = nullptr;
+    }
+
+private:
+    void drain()
+    {
+        for (;;)
+        {
+            uint64_t begin = next_row.fetch_add(job_chunk);
+            if (begin >= job_rows)
+            {
+                return;
+            }
+            uint64_t end = std::min<uint64_t>(begin + job_chunk, job_rows);
+            (*job)((uint32_t)begin, (uint32_t)end);
+        }
+    }
+
+    void worker_loop()
+    {
+        uint64_t seen = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping)
+                {
+                    return;
+                }
+                seen = generation;
+            }
+
+            drain();
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                busy--;
+            }
+            done.notify_one();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(uint32_t, uint32_t)>* job = nullptr;
+    uint32_t job_rows = 0;
+    uint32_t job_chunk = 1;
+    std::atomic<uint64_t> next_row{ 0 };
+    uint32_t busy = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+};
+
+std::mutex pool_mutex;
+std::unique_ptr<RowThreadPool> pool;
+
+// The pool is kept alive between calls so repeated renders don't pay for thread creation, pool_mutex must be held
+RowThreadPool& shared_pool(uint32_t thread_count)
+{
+    if (thread_count == 0)
+    {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (!pool || pool->size() != thread_count)
+    {
+        pool.reset();
+        pool.reset(new RowThreadPool(thread_count));
+    }
+    return *pool;
+}
+
+// Image and kernel shared by all rectangles of an adaptive render
+struct AdaptiveImage {
+    uint32_t* out;
+    uint32_t width;
+    const fractal_params* params;
+    row_kernel_fn row_kernel;
+    const float* r0;
+    const float* i0;
+};
+
+// Per-task buffers that let the vector kernels render the points of a row or column segment
+struct AdaptiveScratch {
+    float r[CPU_ADAPTIVE_BLOCK_SIZE];
+    float i[CPU_ADAPTIVE_BLOCK_SIZE];
+    uint32_t column[CPU_ADAPTIVE_BLOCK_SIZE];
+};
+
+} // namespace
+
+void cpu_generate_fractal(
+    uint32_t* out,
+    uint32_t width,
+    uint32_t height,
+    const fractal_params* params,
+    cpu_simd_level level,
+    uint32_t thread_count)
+{
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    RowThreadPool& workers = shared_pool(thread_count);
+
+    // Aim for a few thousand pixels per task so narrow images don't drown in scheduling
+    uint32_t rows_per_task = std::max(1u, 4096u / std::max(1u, width));
+
+    row_kernel_fn row_kernel = select_row_kernel(level);
+    std::vector<float> r0 = row_table(height, params);
+    std::vector<float> i0 = column_table(width, params);
+
+    workers.run(height, rows_per_task, [&](uint32_t row_begin, uint32_t row_end) {
+        render_rows(out, width, row_begin, row_end, params, row_kernel, r0.data(), i0.data());
+    });
+}
+
+// Iterates columns [col_begin, col_end) of one row, segments are at most a block long
+static uint64_t evaluate_row(const AdaptiveImage& image, AdaptiveScratch& scratch, uint32_t row, uint32_t col_begin, uint32_t col_end)
+{
+    if (col_begin >= col_end)
+    {
+        return 0;
+    }
+    uint32_t count = col_end - col_begin;
+    std::fill(scratch.r, scratch.r + count, image.r0[row]);
+    image.row_kernel(image.out + (size_t)row * image.width + col_begin, scratch.r, image.i0 + col_begin, count, image.params);
+    return count;
+}
+
+// Iterates rows [row_begin, row_end) of one column
+static uint64_t evaluate_column(const AdaptiveImage& image, AdaptiveScratch& scratch, uint32_t col, uint32_t row_begin, uint32_t row_end)
+{
+    if (row_begin >= row_end)
+    {
+        return 0;
+    }
+    uint32_t count = row_end - row_begin;
+    std::fill(scratch.i, scratch.i + count, image.i0[col]);
+    image.row_kernel(scratch.column, image.r0 + row_begin, scratch.i, count, image.params);
+    for (uint32_t k = 0; k < count; k++)
+    {
+        image.out[(size_t)(row_begin + k) * image.width + col] = scratch.column[k];
+    }
+    return count;
+}
+
+// Resolves the interior of the rectangle [x0, x1] x [y0, y1] whose border is already rendered.
+// A border with a single iteration count is filled, otherwise the rectangle is split in four
+// along a new cross of rendered pixels. Returns the number of pixels iterated.
+static uint64_t subdivide(const AdaptiveImage& image, AdaptiveScratch& scratch, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1)
+{
+    if (x1 - x0 < 2 || y1 - y0 < 2)
+    {
+        return 0;
+    }
+
+    uint32_t* out = image.out;
+    size_t width = image.width;
+    uint32_t value = out[y0 * width + x0];
+    bool uniform = true;
+    for (uint32_t x = x0; x <= x1 && uniform; x++)
+    {
+        uniform = out[y0 * width + x] == value && out[y1 * width + x] == value;
+    }
+    for (uint32_t y = y0 + 1; y < y1 && uniform; y++)
+    {
+        uniform = out[y * width + x0] == value && out[y * width + x1] == value;
+    }
+
+    if (uniform)
+    {
+        for (uint32_t y = y0 + 1; y < y1; y++)
+        {
+            std::fill(out + y * width + x0 + 1, out + y * width + x1, value);
+        }
+        return 0;
+    }
+
+    uint64_t evaluated = 0;
+    if (x1 - x0 <= CPU_ADAPTIVE_MIN_SIZE || y1 - y0 <= CPU_ADAPTIVE_MIN_SIZE)
+    {
+        for (uint32_t y = y0 + 1; y < y1; y++)
+        {
+            evaluated += evaluate_row(image, scratch, y, x0 + 1, x1);
+        }
+        return evaluated;
+    }
+
+    uint32_t xm = x0 + (x1 - x0) / 2;
+    uint32_t ym = y0 + (y1 - y0) / 2;
+    evaluated += evaluate_row(image, scratch, ym, x0 + 1, x1);
+    evaluated += evaluate_column(image, scratch, xm, y0 + 1, ym);
+    evaluated += evaluate_column(image, scratch, xm, ym + 1, y1);
+
+    evaluated += subdivide(image, scratch, x0, y0, xm, ym);
+    evaluated += subdivide(image, scratch, xm, y0, x1, ym);
+    evaluated += subdivide(image, scratch, x0, ym, xm, y1);
+    evaluated += subdivide(image, scratch, xm, ym, x1, y1);
+    return evaluated;
+}
+
+uint64_t cpu_generate_fractal_adaptive(
+    uint32_t* out,
+    uint32_t width,
+    uint32_t height,
+    const fractal_params* params,
+    cpu_simd_level level,
+    uint32_t thread_count)
+{
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    RowThreadPool& workers = shared_pool(thread_count);
+
+    std::vector<float> r0 = row_table(height, params);
+    std::vector<float> i0 = column_table(width, params);
+    AdaptiveImage image = { out, width, params, select_row_kernel(level), r0.data(), i0.data() };
+
+    // Every block renders its own border and is subdivided independently, one block per task
+    uint32_t blocks_x = (width + CPU_ADAPTIVE_BLOCK_SIZE - 1) / CPU_ADAPTIVE_BLOCK_SIZE;
+    uint32_t blocks_y = (height + CPU_ADAPTIVE_BLOCK_SIZE - 1) / CPU_ADAPTIVE_BLOCK_SIZE;
+    std::atomic<uint64_t> evaluated{ 0 };
+
+    workers.run(blocks_x * blocks_y, 1, [&](uint32_t block_begin, uint32_t block_end) {
+        AdaptiveScratch scratch;
+        uint64_t block_evaluated = 0;
+        for (uint32_t block = block_begin; block < block_end; block++)
+        {
+            uint32_t x0 = (block % blocks_x) * CPU_ADAPTIVE_BLOCK_SIZE;
+            uint32_t y0 = (block / blocks_x) * CPU_ADAPTIVE_BLOCK_SIZE;
+            uint32_t x1 = std::min(x0 + CPU_ADAPTIVE_BLOCK_SIZE, width) - 1;
+            uint32_t y1 = std::min(y0 + CPU_ADAPTIVE_BLOCK_SIZE, height) - 1;
+
+            block_evaluated += evaluate_row(image, scratch, y0, x0, x1 + 1);
+            if (y1 > y0)
+            {
+                block_evaluated += evaluate_row(image, scratch, y1, x0, x1 + 1);
+            }
+            block_evaluated += evaluate_column(image, scratch, x0, y0 + 1, y1);
+            if (x1 > x0)
+            {
+                block_evaluated += evaluate_column(image, scratch, x1, y0 + 1, y1);
+            }
+            block_evaluated += subdivide(image, scratch, x0, y0, x1, y1);
+        }
+        evaluated += block_evaluated;
+    });
+    return evaluated;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "fractal_params.h"
+
+typedef enum cpu_simd_level {
+    CPU_SIMD_SCALAR = 0,
+    CPU_SIMD_SSE2,
+    CPU_SIMD_AVX2,
+    CPU_SIMD_AVX512,
+    CPU_SIMD_AUTO
+} cpu_simd_level;
+
+cpu_simd_level cpu_detect_simd_level(void);
+// Parses scalar, sse2, avx2, avx512 or auto, returns -1 for any other name
+int cpu_simd_level_from_string(const char* name, cpu_simd_level* level);
+const char* cpu_simd_level_as_string(cpu_simd_level level);
+
+// Renders rows [row_begin, row_end) of a width x height image into out (row-major)
+void cpu_generate_fractal_rows(
+    uint32_t* out,
+    uint32_t width,
+    uint32_t height,
+    uint32_t row_begin,
+    uint32_t row_end,
+    const fractal_params* params,
+    cpu_simd_level level
+);
+
+// Renders the whole image, spreading rows over a pool of thread_count workers (0 = all cores)
+void cpu_generate_fractal(
+    uint32_t* out,
+    uint32_t width,
+    uint32_t height,
+    const fractal_params* params,
+    cpu_simd_level level,
+    uint32_t thread_count
+);
+
+// Like cpu_generate_fractal, but only iterates the borders of rectangles (Mariani-Silver): a rectangle
+// whose border has a single iteration count is filled with it, others are split. Exact wherever the
+// escape-time bands are connected; detail thinner than a rectangle that never touches its border is lost.
+// Returns the number of pixels iterated.
+uint64_t cpu_generate_fractal_adaptive(
+    uint32_t* out,
+    uint32_t width,
+    uint32_t height,
+    const fractal_params* params,
+    cpu_simd_level level,
+    uint32_t thread_count
+);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,49 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define FRACTAL_DEFAULT_MAX_ITERATIONS 63
+#define FRACTAL_DEFAULT_C_REAL 0.17
+#define FRACTAL_DEFAULT_C_IMAG 0.57
+
+// The default view maps the image onto [-1, 1] along both axes
+#define FRACTAL_DEFAULT_CENTER_REAL 0.0
+#define FRACTAL_DEFAULT_CENTER_IMAG 0.0
+#define FRACTAL_DEFAULT_SCALE 1.0
+
+// What the GPU kernel writes per pixel
+typedef enum fractal_output {
+    FRACTAL_OUTPUT_PACKED = 0,  // (count << 2) | 0xff000000 as a uint; the CPU backend packs count << 10 instead
+    FRACTAL_OUTPUT_COUNT8,      // 8-bit iteration count saturated at 255, tile rows padded to 4 bytes
+    FRACTAL_OUTPUT_RGBA8        // Count mapped through the palette buffer to RGBA8
+} fractal_output;
+
+// Kernel parameters shared by the CPU backend and shader/fractal.comp. The Julia constant and the
+// iteration cap are specialization constants, the view and the iteration count are push constants.
+typedef struct fractal_params {
+    uint32_t max_iterations;
+    double c_real;      // Julia constant, the shader gets it rounded to float
+    double c_imag;
+    double center_real; // Point mapped to the middle of the image (rows run along the real axis)
+    double center_imag;
+    double scale;       // Half the extent of the view along each axis
+    fractal_output output;  // GPU only, a specialization constant
+} fractal_params;
+
+static inline fractal_params fractal_default_params(void)
+{
+    fractal_params params = {
+        FRACTAL_DEFAULT_MAX_ITERATIONS, FRACTAL_DEFAULT_C_REAL, FRACTAL_DEFAULT_C_IMAG,
+        FRACTAL_DEFAULT_CENTER_REAL, FRACTAL_DEFAULT_CENTER_IMAG, FRACTAL_DEFAULT_SCALE,
+        FRACTAL_OUTPUT_PACKED
+    };
+    return params;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,4 +1,4 @@
-#include <chrono>
+#include <vector>
 
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb_image_write.h>
@@ -6,189 +6,786 @@
 #include <stdio.h>
 #include <time.h>
 #include <string.h>
+#include <stdlib.h>
 
-#include "instance.h"
-#include "device.h"
-#include "compute.h"
-#include "memory.h"
+#include "vkrt/instance.h"
+#include "vkrt/device.h"
+#include "vkrt/compute.h"
+#include "vkrt/memory.h"
 #include "pipeline.h"
-
-#define width 256
-#define height 256
-
-uint32_t vk_input_data[width];
-uint32_t vk_output_data[height][width];
-
-double getTime()
+#include "tile.h"
+#include "fractal_cpu.h"
+#include "fractal_params.h"
+#include "render.h"
+#include "benchmarks.h"
+#include "animation.h"
+#include "render_service.h"
+#include "vkrt/pipeline_cache.h"
+#include "deep_zoom.h"
+#include "export.h"
+#include "adaptive.h"
+#include "equalize.h"
+#include "service.h"
+#include "multi_device.h"
+#include "embedded_shaders.h"
+
+// Input, output and palette buffers, see shader/fractal.comp
+VkDescriptorSetLayout vk_create_descriptor_set_layout(VkDevice vk_device)
 {
-     // Get the current time from the system clock
-     auto now = std::chrono::high_resolution_clock::now();
-
-     // Convert the current time to time since epoch
-     auto duration = now.time_since_epoch();
-
-     // Convert duration to microseconds
-     auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
-
-	 return microseconds;
+    return vk_create_storage_set_layout(vk_device, 3);
 }
 
-void generate_fractal_cpu()
+int main(int argc, char* argv[])
 {
-    for (uint32_t row = 0; row < height; row++)
+    // Usage: hello-fractal [width] [height] [--cpu-simd scalar|sse2|avx2|avx512|auto] [--cpu-threads n]
+    //                      [--bench] [--warmup n] [--iterations n] [--json file|-] [--bench-dispatch n]
+    //                      [--bench-batch n] [--bench-adaptive] [--adaptive] [--equalize]
+    //                      [--max-iter n] [--julia re im] [--local-size n] [--sweep-max-iter n,n,...]
+    //                      [--center re im] [--scale s] [--animate frames] [--zoom-scale s] [--zoom-max-iter n]
+    //                      [--deep re im] [--format png|raw] [--output pattern] [--export-threads n]
+    //                      [--gpu-output packed|count8|rgba] [--single-queue] [--serve file|-] [--serve-jobs n]
+    //                      [--device n] [--multi-device]
+    render_options options = render_default_options();
+
+    // Physical device, -1 asks on stdin
+    int device_index = -1;
+
+    // Splits single-image renders across every physical device, enabled by --multi-device
+    bool multi_device = false;
+
+    // Re-renders the image once per iteration cap, enabled by --sweep-max-iter
+    std::vector<uint32_t> sweep_max_iterations;
+
+    // Deep zoom around a center given with more digits than a double holds, enabled by --deep
+    const char* deep_real = NULL;
+    const char* deep_imag = NULL;
+    deep_center deep_view;
+
+    // --bench and the options implying it replace the single timed run with a benchmark
+    bool bench = false;
+    bool bench_adaptive = false;
+
+    int positional = 0;
+    for (int i = 1; i < argc; i++)
     {
-        for (uint32_t col = 0; col < width; col++)
+        if (strcmp(argv[i], "--cpu-simd") == 0 && i + 1 < argc)
         {
-            float r = (float)row / 128.0 - 1.0;
-            float i = (float)col / 128.0 - 1.0;
-
-            uint32_t cnt = 0;
-            while (((r * r + i * i) < 4.0) && (cnt < 63))
+            const char* level = argv[++i];
+            if (cpu_simd_level_from_string(level, &options.cpu_level) != 0)
             {
-                float temp = r * r - i * i + 0.17;
-                i = 2 * r * i + 0.57;
-                r = temp;
-                cnt++;
+                printf("Unknown SIMD level: %s, expected scalar, sse2, avx2, avx512 or auto.\n", level);
+                return -1;
             }
-            vk_output_data[row][col] = (cnt << 10) | 0xff000000;
+        }
+        else if (strcmp(argv[i], "--cpu-threads") == 0 && i + 1 < argc)
+        {
+            options.cpu_threads = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--bench") == 0)
+        {
+            bench = true;
+        }
+        else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+        {
+            options.bench_warmup = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+        {
+            options.bench_iterations = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--bench-dispatch") == 0 && i + 1 < argc)
+        {
+            bench = true;
+            options.bench_dispatches = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--bench-batch") == 0 && i + 1 < argc)
+        {
+            bench = true;
+            options.bench_batch_jobs = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--bench-adaptive") == 0)
+        {
+            bench = true;
+            bench_adaptive = true;
+            options.adaptive = 1;
+        }
+        else if (strcmp(argv[i], "--adaptive") == 0)
+        {
+            options.adaptive = 1;
+        }
+        else if (strcmp(argv[i], "--equalize") == 0)
+        {
+            options.equalize = 1;
+        }
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+        {
+            bench = true;
+            options.bench_json = argv[++i];
+        }
+        else if (strcmp(argv[i], "--max-iter") == 0 && i + 1 < argc)
+        {
+            const char* count = argv[++i];
+            char* end = NULL;
+            options.params.max_iterations = (uint32_t)strtoul(count, &end, 10);
+            if (*count < '0' || *count > '9' || *end != '\0' || options.params.max_iterations == 0)
+            {
+                printf("Invalid iteration count: %s, expected a positive number.\n", count);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--julia") == 0 && i + 2 < argc)
+        {
+            options.params.c_real = strtod(argv[++i], NULL);
+            options.params.c_imag = strtod(argv[++i], NULL);
+        }
+        else if (strcmp(argv[i], "--center") == 0 && i + 2 < argc)
+        {
+            options.params.center_real = strtod(argv[++i], NULL);
+            options.params.center_imag = strtod(argv[++i], NULL);
+        }
+        else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+        {
+            const char* format = argv[++i];
+            if (export_format_from_string(format, &options.output_format) != 0)
+            {
+                printf("Unknown output format: %s, expected png or raw.\n", format);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+        {
+            // The frame number is the only argument, so the pattern must have exactly one %u
+            options.frame_pattern = argv[++i];
+            const char* conversion = strchr(options.frame_pattern, '%');
+            size_t width_digits = conversion != NULL ? strspn(conversion + 1, "0123456789") : 0;
+            if (conversion == NULL || conversion[1 + width_digits] != 'u' || strchr(conversion + 1, '%') != NULL)
+            {
+                printf("The output pattern needs exactly one %%u for the frame number.\n");
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--gpu-output") == 0 && i + 1 < argc)
+        {
+            const char* mode = argv[++i];
+            if (strcmp(mode, "packed") == 0)
+            {
+                options.params.output = FRACTAL_OUTPUT_PACKED;
+            }
+            else if (strcmp(mode, "count8") == 0)
+            {
+                options.params.output = FRACTAL_OUTPUT_COUNT8;
+            }
+            else if (strcmp(mode, "rgba") == 0)
+            {
+                options.params.output = FRACTAL_OUTPUT_RGBA8;
+            }
+            else
+            {
+                printf("Unknown GPU output mode: %s, expected packed, count8 or rgba.\n", mode);
+                return -1;
+            }
+        }
+        else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc)
+        {
+            options.serve_stream = argv[++i];
+        }
+        else if (strcmp(argv[i], "--device") == 0 && i + 1 < argc)
+        {
+            device_index = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--multi-device") == 0)
+        {
+            multi_device = true;
+        }
+        else if (strcmp(argv[i], "--serve-jobs") == 0 && i + 1 < argc)
+        {
+            options.serve_jobs = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--single-queue") == 0)
+        {
+            options.single_queue = 1;
+        }
+        else if (strcmp(argv[i], "--export-threads") == 0 && i + 1 < argc)
+        {
+            options.export_threads = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--deep") == 0 && i + 2 < argc)
+        {
+            deep_real = argv[++i];
+            deep_imag = argv[++i];
+            options.params.center_real = strtod(deep_real, NULL);
+            options.params.center_imag = strtod(deep_imag, NULL);
+        }
+        else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc)
+        {
+            options.params.scale = strtod(argv[++i], NULL);
+        }
+        else if (strcmp(argv[i], "--animate") == 0 && i + 1 < argc)
+        {
+            options.animate_frames = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--zoom-scale") == 0 && i + 1 < argc)
+        {
+            options.zoom_scale = strtod(argv[++i], NULL);
+        }
+        else if (strcmp(argv[i], "--zoom-max-iter") == 0 && i + 1 < argc)
+        {
+            options.zoom_max_iterations = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--local-size") == 0 && i + 1 < argc)
+        {
+            options.local_size_x = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--sweep-max-iter") == 0 && i + 1 < argc)
+        {
+            // Comma separated list of iteration caps
+            const char* list = argv[++i];
+            for (const char* p = list; ; )
+            {
+                char* end = NULL;
+                uint32_t max_iterations = (uint32_t)strtoul(p, &end, 10);
+                if (*p < '0' || *p > '9' || (*end != ',' && *end != '\0') || max_iterations == 0)
+                {
+                    printf("Invalid iteration caps: %s, expected positive numbers separated by commas.\n", list);
+                    return -1;
+                }
+                sweep_max_iterations.push_back(max_iterations);
+                if (*end == '\0')
+                {
+                    break;
+                }
+                p = end + 1;
+            }
+        }
+        else if (positional == 0)
+        {
+            options.width = options.height = (uint32_t)strtoul(argv[i], NULL, 10);
+            positional++;
+        }
+        else if (positional == 1)
+        {
+            options.height = (uint32_t)strtoul(argv[i], NULL, 10);
+            positional++;
+        }
+        else
+        {
+            printf("Unknown argument: %s\n", argv[i]);
+            return -1;
         }
     }
-}
+    if (options.width == 0 || options.height == 0)
+    {
+        printf("Invalid image size.\n");
+        return -1;
+    }
+    if (bench && options.bench_iterations == 0)
+    {
+        printf("At least one benchmark iteration is required.\n");
+        return -1;
+    }
+    printf("Image size: %u x %u\n", options.width, options.height);
+    if (options.params.scale <= 0.0)
+    {
+        printf("The scale must be positive.\n");
+        return -1;
+    }
+    printf("Parameters: max iterations %u, c = %g + %gi, workgroup size %u\n", options.params.max_iterations, options.params.c_real, options.params.c_imag, options.local_size_x);
+    printf("View: center %g + %gi, scale %g\n", options.params.center_real, options.params.center_imag, options.params.scale);
 
+    if (options.cpu_level == CPU_SIMD_AUTO || options.cpu_level > cpu_detect_simd_level())
+    {
+        options.cpu_level = cpu_detect_simd_level();
+    }
+    printf("CPU backend: %s\n", cpu_simd_level_as_string(options.cpu_level));
 
-VkDescriptorSetLayout vk_create_descriptor_set_layout(VkDevice vk_device)
-{
-    VkDescriptorSetLayoutBinding bindings[2];
-    memset(&bindings, 0, sizeof(bindings));
+    // Largest iteration count of the run, the deep zoom orbits and the palette must cover it
+    uint32_t run_iterations = options.params.max_iterations;
+    if ((options.animate_frames > 0 || options.bench_batch_jobs > 0) && options.zoom_max_iterations > run_iterations)
+    {
+        run_iterations = options.zoom_max_iterations;
+    }
+    for (uint32_t max_iterations : sweep_max_iterations)
+    {
+        if (max_iterations > run_iterations)
+        {
+            run_iterations = max_iterations;
+        }
+    }
 
-    bindings[0].binding = 0;
-    bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    bindings[0].descriptorCount = 1;
+    // In deep zoom mode the input buffer carries the reference orbits
+    bool deep = deep_real != NULL;
+    if (deep)
+    {
+        if (deep_parse_center(deep_real, deep_imag, &deep_view) != 0)
+        {
+            return -1;
+        }
+        if (options.bench_batch_jobs > 0)
+        {
+            printf("Batches render float views, there is one reference orbit for the whole deep zoom.\n");
+            return -1;
+        }
+        if (bench)
+        {
+            printf("The CPU renderers work in float coordinates, the benchmarks have nothing to compare the deep zoom with.\n");
+            return -1;
+        }
+        if (options.adaptive)
+        {
+            printf("Adaptive rendering works in float coordinates, it has no deep zoom mode.\n");
+            return -1;
+        }
+        if (options.equalize)
+        {
+            printf("In deep zoom mode the input buffer carries the orbits, it has no room for the histogram.\n");
+            return -1;
+        }
+        double min_scale = deep_min_scale(options.width, options.height);
+        if (options.params.scale < min_scale || (options.animate_frames > 0 && zoom_params(&options, options.animate_frames - 1, options.animate_frames).scale < min_scale))
+        {
+            printf("Deep zoom supports scales down to %g at %u x %u.\n", min_scale, options.width, options.height);
+            return -1;
+        }
+    }
 
-    bindings[1].binding = 1;
-    bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    bindings[1].descriptorCount = 1;
+    if (options.adaptive && options.animate_frames > 0)
+    {
+        printf("The animation renders every pixel, --adaptive only applies to single images.\n");
+        return -1;
+    }
+    if (options.equalize && (options.animate_frames > 0 || options.adaptive))
+    {
+        printf("--equalize only applies to full renders of single images.\n");
+        return -1;
+    }
+    if (multi_device && (deep || options.adaptive || options.equalize || bench || options.animate_frames > 0 || options.serve_stream != NULL || !sweep_max_iterations.empty()))
+    {
+        printf("--multi-device splits plain renders of single images.\n");
+        return -1;
+    }
+    if (options.serve_stream != NULL)
+    {
+        if (deep || options.adaptive || options.equalize || bench || options.animate_frames > 0)
+        {
+            printf("--serve renders plain float views, it combines with no other mode.\n");
+            return -1;
+        }
+        if (options.serve_jobs == 0 || options.serve_jobs > SERVICE_MAX_JOBS)
+        {
+            printf("The service renders 1 to %u jobs at once.\n", SERVICE_MAX_JOBS);
+            return -1;
+        }
 
-    VkDescriptorSetLayoutCreateInfo createInfo;
-    memset(&createInfo, 0, sizeof(createInfo));
-    createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    createInfo.bindingCount = 2;
-    createInfo.pBindings = bindings;
+        // Nobody is there to answer the device prompt, and stdin may carry the jobs
+        if (device_index < 0)
+        {
+            device_index = 0;
+        }
+    }
 
-    VkDescriptorSetLayout vk_descriptor_set_layout = VK_NULL_HANDLE;
-    if (vkCreateDescriptorSetLayout(vk_device, &createInfo, NULL, &vk_descriptor_set_layout) != VK_SUCCESS)
+    size_t input_size = deep ? deep_orbit_buffer_size(run_iterations) : options.width * sizeof(uint32_t);
+    uint32_t* vk_input_data = (uint32_t*)calloc(1, input_size);
+    uint32_t* vk_output_data = (uint32_t*)malloc((size_t)options.width * options.height * sizeof(uint32_t));
+    if (vk_input_data == NULL || vk_output_data == NULL)
     {
-        printf("Failed to create a descriptor set layout handle.'n");
+        printf("Failed to allocate the image.\n");
+        return -1;
     }
-    return vk_descriptor_set_layout;
-}
 
-int main(int argc, char* argv[])
-{
+    if (deep)
+    {
+        double time = getTime();
+        deep_orbit_header orbits = deep_build_orbits(&deep_view, &options.params, run_iterations, vk_input_data);
+        time = getTime() - time;
+        printf("Deep zoom: reference orbit %u points, critical orbit %u points, %f ms.\n",
+               orbits.reference_length, orbits.critical_length, time / 1000.0f);
+    }
+
+    register_embedded_shaders();
+
 	// Create a Vulkan instance and select a physical device
     VkInstance vk_instance = vk_create_instance();
-    VkPhysicalDevice vk_phy_device = vk_create_physical_device(vk_instance);
+    if (multi_device)
+    {
+        int result = run_multi_device(vk_instance, &options, vk_output_data);
+        free(vk_output_data);
+        free(vk_input_data);
+        return result;
+    }
+    VkPhysicalDevice vk_phy_device = vk_select_physical_device(vk_instance, device_index);
+    if (vk_phy_device == VK_NULL_HANDLE)
+    {
+        return -1;
+    }
+
+	// Split the image into tiles that fit the device limits
+    vk_tile_plan plan;
+    int planned = options.adaptive ? vk_plan_adaptive_tiles(vk_phy_device, options.width, options.height, options.local_size_x,
+                                                            options.params.output, FRACTAL_MAX_TILE_BYTES, &plan)
+                                   : vk_plan_tiles(vk_phy_device, options.width, options.height, options.local_size_x,
+                                                   options.params.output, FRACTAL_MAX_TILE_BYTES, &plan);
+    if (planned != 0)
+    {
+        return -1;
+    }
+    printf("Tiles: %u x %u of %u x %u\n", plan.tiles_x, plan.tiles_y, plan.tile_width, plan.tile_height);
 
-	// Create a logical device and a compute queue
-    VkQueue  vk_queue_compute = VK_NULL_HANDLE;
-	uint32_t vk_queue_family_index = 0;
-    VkDevice vk_device = vk_create_device_and_compute_queue(vk_phy_device, &vk_queue_family_index, &vk_queue_compute);
+    if (options.adaptive && vk_check_adaptive(vk_phy_device, &plan) != 0)
+    {
+        return -1;
+    }
+    if (options.equalize && vk_check_equalize(vk_phy_device, &plan) != 0)
+    {
+        return -1;
+    }
 
-	// Define bindings for the descriptor set layout
-	VkDescriptorPool vk_descriptor_pool = vk_create_descriptor_pool(vk_device);
+	// Create a logical device with compute and transfer queues
+    vk_device_queues vk_queues;
+    VkDevice vk_device = vk_create_device_and_queues(vk_phy_device, &vk_queues);
+    if (vk_device == VK_NULL_HANDLE)
+    {
+        return -1;
+    }
+    uint32_t vk_queue_family_index = vk_queues.compute_family;
+    printf("Queues: %u compute in family %u%s, %u transfer in family %u%s\n", vk_queues.compute_count, vk_queues.compute_family,
+           vk_queues.async_compute ? " (async compute)" : "", vk_queues.transfer_count, vk_queues.transfer_family,
+           vk_queues.transfer_family != vk_queues.compute_family ? " (copy engine)" : "");
+
+	// Define bindings for the descriptor set layout, the animation adds one set per readback slot and the service one per job slot
+    uint32_t extra_sets = options.serve_stream != NULL && options.serve_jobs > ANIMATION_READBACK_SLOTS ? options.serve_jobs : ANIMATION_READBACK_SLOTS;
+	VkDescriptorPool vk_descriptor_pool = vk_create_descriptor_pool(vk_device, 1 + extra_sets, 3);
     VkDescriptorSetLayout vk_descriptor_set_layout = vk_create_descriptor_set_layout(vk_device);
 
     VkDescriptorSet vk_descriptor_set = vk_create_descriptor_set(vk_device, vk_descriptor_set_layout, vk_descriptor_pool);
 
-	// Create buffers for the input and output data
-    VkDeviceMemory vk_input_buffer_memory = VK_NULL_HANDLE;
-    VkDeviceMemory vk_output_buffer_emory = VK_NULL_HANDLE;
+	// Create buffers for the input data and one output tile
+    uint32_t vk_input_size = (uint32_t)input_size;
+    VkBufferUsageFlags vk_input_usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
 
-    VkBuffer vk_input_buffer = vk_create_buffer_and_memory(vk_phy_device, vk_device, sizeof(vk_input_data), &vk_input_buffer_memory);
-    VkBuffer vk_output_buffer = vk_create_buffer_and_memory(vk_phy_device, vk_device, sizeof(vk_output_data), &vk_output_buffer_emory);
+    // In adaptive mode the input buffer carries the work list of the fill pass
+    if (options.adaptive)
+    {
+        if (vk_adaptive_work_size(&plan) > vk_input_size)
+        {
+            vk_input_size = (uint32_t)vk_adaptive_work_size(&plan);
+        }
+        vk_input_usage |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    }
 
-    vk_update_descriptor_set(vk_device, vk_descriptor_set, sizeof(vk_input_data), sizeof(vk_output_data), vk_input_buffer, vk_output_buffer);
+    // In equalize mode it carries the histogram and the equalized palette
+    if (options.equalize)
+    {
+        if (vk_equalize_buffer_size(options.params.max_iterations) > vk_input_size)
+        {
+            vk_input_size = (uint32_t)vk_equalize_buffer_size(options.params.max_iterations);
+        }
+        vk_input_usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    }
+    uint32_t vk_output_size = (uint32_t)plan.tile_size;
+
+    vk_mapped_memory vk_input_buffer_memory;
+    vk_mapped_memory vk_output_buffer_memory;
+
+    // The host writes the input straight into VRAM when it can (ReBAR / unified memory),
+    // the shader writes the output to device-local memory
+    VkBuffer vk_input_buffer = vk_create_buffer_and_memory(vk_phy_device, vk_device, vk_input_size, vk_input_usage,
+                                                           MEMORY_PLACEMENT_DEVICE_MAPPED, &vk_input_buffer_memory);
+    VkBuffer vk_output_buffer = vk_create_buffer_and_memory(vk_phy_device, vk_device, vk_output_size,
+                                                            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                                            MEMORY_PLACEMENT_DEVICE, &vk_output_buffer_memory);
+
+    // Read a device-only output back through a staging buffer in cached host memory
+    VkBuffer vk_staging_buffer = VK_NULL_HANDLE;
+    vk_mapped_memory vk_staging_buffer_memory;
+    memset(&vk_staging_buffer_memory, 0, sizeof(vk_staging_buffer_memory));
+
+    const vk_mapped_memory* vk_readback_memory = &vk_output_buffer_memory;
+    if (vk_output_buffer_memory.address == NULL)
+    {
+        vk_staging_buffer = vk_create_buffer_and_memory(vk_phy_device, vk_device, vk_output_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                        MEMORY_PLACEMENT_HOST_CACHED, &vk_staging_buffer_memory);
+        vk_readback_memory = &vk_staging_buffer_memory;
+    }
+    printf("Output buffer: %s\n", vk_staging_buffer != VK_NULL_HANDLE ? "device-local, read back through a staging buffer" : "host-visible, read directly");
+
+    // In RGBA mode the shader looks the colors up in a palette with one entry per iteration count, and so
+    // does the equalize scan. The other modes never read it but the binding still needs a buffer.
+    uint32_t palette_entries = options.params.output == FRACTAL_OUTPUT_RGBA8 || options.equalize ? run_iterations + 1 : 1;
+    uint32_t vk_palette_size = palette_entries * 4;
+    vk_mapped_memory vk_palette_buffer_memory;
+    VkBuffer vk_palette_buffer = vk_create_buffer_and_memory(vk_phy_device, vk_device, vk_palette_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                                             MEMORY_PLACEMENT_DEVICE_MAPPED, &vk_palette_buffer_memory);
+    export_build_palette(palette_entries, (unsigned char*)vk_palette_buffer_memory.address);
+    vk_flush_mapped_memory(vk_device, &vk_palette_buffer_memory, 0, vk_palette_size);
+
+    const char* output_names[] = { "packed", "count8", "rgba" };
+    printf("GPU output: %s, %u bytes per tile row.\n", output_names[options.params.output], vk_tile_row_bytes(&plan, plan.tile_width));
+
+    vk_update_descriptor_set(vk_device, vk_descriptor_set, vk_input_size, vk_output_size, vk_palette_size,
+                             vk_input_buffer, vk_output_buffer, vk_palette_buffer);
 
 	// Create the compute shader module
-    VkShaderModule vk_shader_module = vk_create_compute_shader(vk_device, "shader/fractal.spv");
+    VkShaderModule vk_shader_module = vk_create_compute_shader(vk_device, deep ? "shader/fractal_deep.spv" : "shader/fractal.spv");
 	
     // Create a pipeline and a command pool
-    VkPipelineLayout vk_pipeline_layout = vk_create_pipeline_layout(vk_device, vk_descriptor_set_layout);
-
-    VkPipeline vk_pipeline = vk_create_pipline(vk_device, vk_pipeline_layout, vk_descriptor_set_layout, vk_shader_module);
+    VkPipelineLayout vk_pipeline_layout = vk_create_pipeline_layout(vk_device, vk_descriptor_set_layout, sizeof(vk_tile_push_constants));
 
-    VkCommandPool vk_compute_cmd_pool = vk_create_command_pool(vk_device, vk_queue_family_index);
-    VkCommandBuffer vk_command_buffer = vk_prepare_command_buffer(vk_device, vk_pipeline, vk_pipeline_layout, vk_descriptor_set, vk_compute_cmd_pool);
- 
-	// Copy the input data to the GPU
-    vk_copy_to_input_buffer(vk_device, vk_input_data, sizeof(vk_input_data), vk_input_buffer_memory);
-
-    double time = getTime();
-    generate_fractal_cpu();
-    time = getTime() - time;
-    printf("CPU fractal: %f ms.\n", time / 1000.0f);
+    // Reuse the compiled pipeline from the previous launch when the cache matches this device and driver
+    int warm = 0;
+    VkPipelineCache vk_pipeline_cache = vk_create_pipeline_cache(vk_phy_device, vk_device, PIPELINE_CACHE_FILE, &warm);
 
-    // Allocate memory for the image data in RGBA format (4 channels per pixel)
-    unsigned char* image_data = (unsigned char*)malloc(width * height * 4);
+    // Pipelines are specialized per parameter set, so sweeping parameters never recompiles the shader
+    vk_specialized_pipelines vk_pipelines;
+    vk_init_specialized_pipelines(&vk_pipelines, vk_shader_module, vk_pipeline_layout, vk_descriptor_set_layout, vk_pipeline_cache);
 
-    // Convert the uint32_t color data into RGBA format
-    for (int row = 0; row < height; row++)
+    double pipeline_time = getTime();
+    VkPipeline vk_pipeline = vk_get_specialized_pipeline(vk_device, &vk_pipelines, options.local_size_x, &options.params);
+    pipeline_time = getTime() - pipeline_time;
+    if (vk_pipeline == VK_NULL_HANDLE)
     {
-        for (int col = 0; col < width; col++)
+        return -1;
+    }
+    printf("Pipeline creation: %f ms (%s cache).\n", pipeline_time / 1000.0f, warm ? "warm" : "cold");
+
+    // The adaptive passes share the layout and descriptor set of the full render
+    vk_specialized_pipelines vk_border_pipelines;
+    vk_specialized_pipelines vk_fill_pipelines;
+    memset(&vk_border_pipelines, 0, sizeof(vk_border_pipelines));
+    memset(&vk_fill_pipelines, 0, sizeof(vk_fill_pipelines));
+    VkPipeline vk_border_pipeline = VK_NULL_HANDLE;
+    VkPipeline vk_fill_pipeline = VK_NULL_HANDLE;
+    if (options.adaptive)
+    {
+        vk_init_specialized_pipelines(&vk_border_pipelines, vk_create_compute_shader(vk_device, "shader/fractal_adaptive_border.spv"),
+                                      vk_pipeline_layout, vk_descriptor_set_layout, vk_pipeline_cache);
+        vk_init_specialized_pipelines(&vk_fill_pipelines, vk_create_compute_shader(vk_device, "shader/fractal_adaptive_fill.spv"),
+                                      vk_pipeline_layout, vk_descriptor_set_layout, vk_pipeline_cache);
+        if (vk_border_pipelines.shader_module == VK_NULL_HANDLE || vk_fill_pipelines.shader_module == VK_NULL_HANDLE)
+        {
+            return -1;
+        }
+        vk_border_pipeline = vk_get_specialized_pipeline(vk_device, &vk_border_pipelines, options.local_size_x, &options.params);
+        vk_fill_pipeline = vk_get_specialized_pipeline(vk_device, &vk_fill_pipelines, options.local_size_x, &options.params);
+        if (vk_border_pipeline == VK_NULL_HANDLE || vk_fill_pipeline == VK_NULL_HANDLE)
         {
-            uint32_t color = vk_output_data[row][col];
+            return -1;
+        }
+    }
 
-            // Extract each channel from the 32-bit packed color
-            image_data[(row * width + col) * 4 + 0] = (color >> 16) & 0xFF;  // Red
-            image_data[(row * width + col) * 4 + 1] = (color >> 8) & 0xFF;   // Green
-            image_data[(row * width + col) * 4 + 2] = color & 0xFF;          // Blue
-            image_data[(row * width + col) * 4 + 3] = (color >> 24) & 0xFF;  // Alpha
+    // The equalize passes too, they run after the packed render in the same command buffer
+    vk_specialized_pipelines vk_histogram_pipelines;
+    vk_specialized_pipelines vk_scan_pipelines;
+    vk_specialized_pipelines vk_colorize_pipelines;
+    memset(&vk_histogram_pipelines, 0, sizeof(vk_histogram_pipelines));
+    memset(&vk_scan_pipelines, 0, sizeof(vk_scan_pipelines));
+    memset(&vk_colorize_pipelines, 0, sizeof(vk_colorize_pipelines));
+    vk_equalize_pipelines vk_equalize;
+    memset(&vk_equalize, 0, sizeof(vk_equalize));
+    if (options.equalize)
+    {
+        vk_init_specialized_pipelines(&vk_histogram_pipelines, vk_create_compute_shader(vk_device, "shader/fractal_equalize_histogram.spv"),
+                                      vk_pipeline_layout, vk_descriptor_set_layout, vk_pipeline_cache);
+        vk_init_specialized_pipelines(&vk_scan_pipelines, vk_create_compute_shader(vk_device, "shader/fractal_equalize_scan.spv"),
+                                      vk_pipeline_layout, vk_descriptor_set_layout, vk_pipeline_cache);
+        vk_init_specialized_pipelines(&vk_colorize_pipelines, vk_create_compute_shader(vk_device, "shader/fractal_equalize_colorize.spv"),
+                                      vk_pipeline_layout, vk_descriptor_set_layout, vk_pipeline_cache);
+        if (vk_histogram_pipelines.shader_module == VK_NULL_HANDLE || vk_scan_pipelines.shader_module == VK_NULL_HANDLE ||
+            vk_colorize_pipelines.shader_module == VK_NULL_HANDLE)
+        {
+            return -1;
+        }
+        vk_equalize.fractal = vk_pipeline;
+        vk_equalize.histogram = vk_get_specialized_pipeline(vk_device, &vk_histogram_pipelines, options.local_size_x, &options.params);
+        vk_equalize.scan = vk_get_specialized_pipeline(vk_device, &vk_scan_pipelines, options.local_size_x, &options.params);
+        vk_equalize.colorize = vk_get_specialized_pipeline(vk_device, &vk_colorize_pipelines, options.local_size_x, &options.params);
+        if (vk_equalize.histogram == VK_NULL_HANDLE || vk_equalize.scan == VK_NULL_HANDLE || vk_equalize.colorize == VK_NULL_HANDLE)
+        {
+            return -1;
         }
     }
-    stbi_write_png("fractal_cpu.png", width, height, 4, image_data, width * 4);
 
-	// Clear the output data
-    memset(vk_output_data, 0, sizeof(vk_output_data));
+    VkCommandPool vk_compute_cmd_pool = vk_create_command_pool(vk_device, vk_queue_family_index);
+
+    vk_submit_context vk_submit;
+    if (vk_create_submit_context(vk_device, vk_queue_family_index, &vk_submit) != 0)
+    {
+        return -1;
+    }
+ 
+	// Copy the input data to the GPU
+    vk_copy_to_input_buffer(vk_device, vk_input_data, (uint32_t)input_size, &vk_input_buffer_memory);
+
+    // Everything the modes below share, each one only adds its own pipelines
+    render_context context = {};
+    context.options = &options;
+    context.phy_device = vk_phy_device;
+    context.device = vk_device;
+    context.queues = &vk_queues;
+    context.pipelines = &vk_pipelines;
+    context.pipeline_layout = vk_pipeline_layout;
+    context.descriptor_set_layout = vk_descriptor_set_layout;
+    context.descriptor_pool = vk_descriptor_pool;
+    context.descriptor_set = vk_descriptor_set;
+    context.command_pool = vk_compute_cmd_pool;
+    context.submit = &vk_submit;
+    context.input_buffer = vk_input_buffer;
+    context.input_memory = &vk_input_buffer_memory;
+    context.output_buffer = vk_output_buffer;
+    context.staging_buffer = vk_staging_buffer;
+    context.readback_memory = vk_readback_memory;
+    context.plan = &plan;
+    context.image = vk_output_data;
+
+    int result = 0;
+    if (options.serve_stream != NULL)
+    {
+        result = run_service(&context);
+    }
+    else if (options.bench_batch_jobs > 0)
+    {
+        result = run_batch_benchmark(&context);
+    }
+    else if (options.bench_dispatches > 0)
+    {
+        result = run_dispatch_benchmark(&context, vk_pipeline);
+    }
+    else if (bench_adaptive)
+    {
+        result = run_adaptive_benchmark(&context, vk_pipeline, vk_border_pipeline, vk_fill_pipeline);
+    }
+    else if (bench)
+    {
+        result = run_benchmark(&context, vk_pipeline);
+    }
+    else if (options.animate_frames > 0)
+    {
+        result = run_animation(&context);
+    }
+    else
+    {
+        // The CPU renderers work in float coordinates, they have no deep zoom mode
+        double time;
+        if (!deep)
+        {
+            time = getTime();
+            if (options.adaptive)
+            {
+                uint64_t evaluated = generate_fractal_cpu_adaptive(&options, vk_output_data);
+                time = getTime() - time;
+                printf("CPU fractal (adaptive, %.1f%% of the pixels iterated): %f ms.\n", 100.0 * evaluated / ((double)options.width * options.height), time / 1000.0f);
+            }
+            else
+            {
+                generate_fractal_cpu(&options, vk_output_data);
+                time = getTime() - time;
+                printf("CPU fractal: %f ms.\n", time / 1000.0f);
+            }
 
-    time = getTime();
-    vk_compute(vk_device, vk_queue_compute, vk_command_buffer);
-    time = getTime() - time;
+            write_image(&options, vk_output_data, "fractal_cpu", EXPORT_PIXELS_PACKED);
 
-    printf("GPU fractal: %f ms.\n", time / 1000.0f);
+            // Clear the output data
+            memset(vk_output_data, 0, (size_t)options.width * options.height * sizeof(uint32_t));
+        }
 
-	// Copy the output data from the GPU to the CPU
-    vk_copy_from_output_buffer(vk_device, vk_output_data, sizeof(vk_output_data), vk_output_buffer_emory);
+        time = getTime();
+        if (options.adaptive)
+        {
+            uint64_t unresolved_blocks = 0;
+            result = generate_fractal_gpu_adaptive(&context, vk_border_pipeline, vk_fill_pipeline, &options.params, VK_NULL_HANDLE, &unresolved_blocks);
+            time = getTime() - time;
+            if (result == 0)
+            {
+                printf("GPU fractal (adaptive, %llu blocks needed the fill pass): %f ms.\n", (unsigned long long)unresolved_blocks, time / 1000.0f);
+            }
+        }
+        else if (options.equalize)
+        {
+            result = generate_fractal_gpu_equalized(&context, &vk_equalize, &options.params, VK_NULL_HANDLE);
+            time = getTime() - time;
+            if (result == 0)
+            {
+                printf("GPU fractal (equalized, colored on the %s): %f ms.\n", vk_tile_count(&plan) == 1 ? "GPU" : "host", time / 1000.0f);
+            }
+        }
+        else
+        {
+            result = generate_fractal_gpu(&context, vk_pipeline, &options.params, VK_NULL_HANDLE);
+            time = getTime() - time;
+            if (result == 0)
+            {
+                printf("GPU fractal: %f ms.\n", time / 1000.0f);
+            }
+        }
 
-    memset(image_data, 0, sizeof(image_data));
+        // A failed render leaves no image behind
+        if (result == 0)
+        {
+            result = write_image(&options, vk_output_data, "fractal_gpu", gpu_pixels(&options));
+        }
 
-    // Convert the uint32_t color data into RGBA format
-    for (int row = 0; row < height; row++)
-    {
-        for (int col = 0; col < width; col++)
+        // Re-render with other iteration caps, each one only costs a pipeline specialization. A long sweep
+        // evicts the main pipeline from vk_pipelines, so its handle is not used past this point.
+        vk_pipeline = VK_NULL_HANDLE;
+        for (uint32_t i = 0; i < sweep_max_iterations.size() && result == 0; i++)
         {
-            uint32_t color = vk_output_data[row][col];
+            uint32_t max_iterations = sweep_max_iterations[i];
+            fractal_params sweep_params = options.params;
+            sweep_params.max_iterations = max_iterations;
+
+            double sweep_pipeline_time = getTime();
+            VkPipeline vk_sweep_pipeline = vk_get_specialized_pipeline(vk_device, &vk_pipelines, options.local_size_x, &sweep_params);
+            sweep_pipeline_time = getTime() - sweep_pipeline_time;
+            if (vk_sweep_pipeline == VK_NULL_HANDLE)
+            {
+                result = -1;
+                break;
+            }
+
+            time = getTime();
+            result = generate_fractal_gpu(&context, vk_sweep_pipeline, &sweep_params, VK_NULL_HANDLE);
+            time = getTime() - time;
+            if (result != 0)
+            {
+                break;
+            }
+
+            printf("GPU fractal (max iterations %u): %f ms, pipeline %f ms.\n", max_iterations, time / 1000.0f, sweep_pipeline_time / 1000.0f);
 
-            // Extract each channel from the 32-bit packed color
-            image_data[(row * width + col) * 4 + 0] = (color >> 16) & 0xFF;  // Red
-            image_data[(row * width + col) * 4 + 1] = (color >> 8) & 0xFF;   // Green
-            image_data[(row * width + col) * 4 + 2] = color & 0xFF;          // Blue
-            image_data[(row * width + col) * 4 + 3] = (color >> 24) & 0xFF;  // Alpha
+            char name[32];
+            snprintf(name, sizeof(name), "fractal_gpu_%u", max_iterations);
+            result = write_image(&options, vk_output_data, name, gpu_pixels(&options));
         }
     }
-    stbi_write_png("fractal_gpu.png", width, height, 4, image_data, width * 4);
 
-    free(image_data);
+    free(vk_output_data);
+    free(vk_input_data);
 
-    vk_destroy_pipeline(vk_device, vk_pipeline, vk_pipeline_layout, vk_descriptor_set_layout);
+    vk_destroy_specialized_pipelines(vk_device, &vk_pipelines);
+    vk_destroy_specialized_pipelines(vk_device, &vk_border_pipelines);
+    vk_destroy_specialized_pipelines(vk_device, &vk_fill_pipelines);
+    vk_destroy_specialized_pipelines(vk_device, &vk_histogram_pipelines);
+    vk_destroy_specialized_pipelines(vk_device, &vk_scan_pipelines);
+    vk_destroy_specialized_pipelines(vk_device, &vk_colorize_pipelines);
+    vk_destroy_pipeline(vk_device, VK_NULL_HANDLE, vk_pipeline_layout, vk_descriptor_set_layout);
 
+    if (vk_pipeline_cache != VK_NULL_HANDLE)
+    {
+        vk_save_pipeline_cache(vk_phy_device, vk_device, vk_pipeline_cache, PIPELINE_CACHE_FILE);
+        vkDestroyPipelineCache(vk_device, vk_pipeline_cache, NULL);
+    }
+
+    vk_destroy_submit_context(vk_device, &vk_submit);
     vkDestroyCommandPool(vk_device, vk_compute_cmd_pool, NULL);
     vkDestroyDescriptorPool(vk_device, vk_descriptor_pool, NULL);
 
-    vk_destroy_buffers(vk_device, vk_input_buffer, vk_output_buffer, vk_input_buffer_memory, vk_output_buffer_emory);
+    vk_destroy_buffers(vk_device, vk_input_buffer, vk_output_buffer, &vk_input_buffer_memory, &vk_output_buffer_memory);
+    if (vk_staging_buffer != VK_NULL_HANDLE)
+    {
+        vk_destroy_buffer(vk_device, vk_staging_buffer, &vk_staging_buffer_memory);
+    }
+    vk_destroy_buffer(vk_device, vk_palette_buffer, &vk_palette_buffer_memory);
 
     vkDestroyDevice(vk_device, NULL);
 
-    return 0;
+    return result;
 }
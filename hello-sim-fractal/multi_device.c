@@ -0,0 +1,310 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "multi_device.h"
+#include "vkrt/kernel.h"
+#include "vkrt/instance.h"
+#include "export.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Size of the reduced view every device renders on its own before the split
+#define MULTI_DEVICE_CALIBRATION_SIZE 256
+#define MULTI_DEVICE_CALIBRATION_RUNS 3     // The first one only warms up
+
+int vk_open_fractal_device(VkPhysicalDevice vk_phy_device, const fractal_params* params, uint32_t local_size_x,
+                           uint32_t max_width, uint32_t palette_entries, vk_fractal_device* device)
+{
+    memset(device, 0, sizeof(*device));
+    device->phy_device = vk_phy_device;
+    device->params = *params;
+    device->local_size_x = local_size_x;
+
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(vk_phy_device, &deviceProperties);
+    memcpy(device->name, deviceProperties.deviceName, sizeof(device->name));
+
+    // The tile buffer holds the largest tile any image up to max_width wide needs on this device
+    vk_tile_plan plan;
+    if (vk_plan_tiles(vk_phy_device, max_width, UINT32_MAX / max_width, local_size_x, params->output, FRACTAL_MAX_TILE_BYTES, &plan) != 0)
+    {
+        return -1;
+    }
+    device->tile_bytes = plan.tile_size;
+
+    device->device = vk_create_device_and_queues(vk_phy_device, &device->queues);
+    if (device->device == VK_NULL_HANDLE)
+    {
+        return -1;
+    }
+    VkDevice vk_device = device->device;
+
+    device->descriptor_set_layout = vk_create_descriptor_set_layout(vk_device);
+    device->descriptor_pool = vk_create_descriptor_pool(vk_device, 1, 3);
+    device->descriptor_set = vk_create_descriptor_set(vk_device, device->descriptor_set_layout, device->descriptor_pool);
+
+    // The plain render never reads the input buffer, but the binding still needs one
+    uint32_t input_size = max_width * sizeof(uint32_t);
+    uint32_t palette_size = palette_entries * 4;
+    device->input_buffer = vk_create_buffer_and_memory(vk_phy_device, vk_device, input_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                                       MEMORY_PLACEMENT_DEVICE_MAPPED, &device->input_memory);
+    device->output_buffer = vk_create_buffer_and_memory(vk_phy_device, vk_device, (uint32_t)device->tile_bytes,
+                                                        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                                        MEMORY_PLACEMENT_DEVICE, &device->output_memory);
+    if (device->output_buffer != VK_NULL_HANDLE && device->output_memory.address == NULL)
+    {
+        device->staging_buffer = vk_create_buffer_and_memory(vk_phy_device, vk_device, (uint32_t)device->tile_bytes, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                             MEMORY_PLACEMENT_HOST_CACHED, &device->staging_memory);
+    }
+    device->palette_buffer = vk_create_buffer_and_memory(vk_phy_device, vk_device, palette_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                                         MEMORY_PLACEMENT_DEVICE_MAPPED, &device->palette_memory);
+    if (device->descriptor_set == VK_NULL_HANDLE || device->input_buffer == VK_NULL_HANDLE || device->output_buffer == VK_NULL_HANDLE ||
+        (device->output_memory.address == NULL && device->staging_buffer == VK_NULL_HANDLE) || device->palette_buffer == VK_NULL_HANDLE)
+    {
+        vk_close_fractal_device(device);
+        return -1;
+    }
+    export_build_palette(palette_entries, (unsigned char*)device->palette_memory.address);
+    vk_flush_mapped_memory(vk_device, &device->palette_memory, 0, palette_size);
+
+    vk_update_descriptor_set(vk_device, device->descriptor_set, input_size, (uint32_t)device->tile_bytes, palette_size,
+                             device->input_buffer, device->output_buffer, device->palette_buffer);
+
+    // Devices don't share pipeline caches, each one compiles its own
+    device->pipeline_layout = vk_create_pipeline_layout(vk_device, device->descriptor_set_layout, sizeof(vk_tile_push_constants));
+    vk_init_specialized_pipelines(&device->pipelines, vk_create_compute_shader(vk_device, "shader/fractal.spv"),
+                                  device->pipeline_layout, device->descriptor_set_layout, VK_NULL_HANDLE);
+    device->pipeline = device->pipelines.shader_module != VK_NULL_HANDLE ?
+                       vk_get_specialized_pipeline(vk_device, &device->pipelines, local_size_x, params) : VK_NULL_HANDLE;
+    if (device->pipeline == VK_NULL_HANDLE || vk_create_submit_context(vk_device, device->queues.compute_family, &device->submit) != 0)
+    {
+        vk_close_fractal_device(device);
+        return -1;
+    }
+    return 0;
+}
+
+void vk_close_fractal_device(vk_fractal_device* device)
+{
+    VkDevice vk_device = device->device;
+    if (vk_device == VK_NULL_HANDLE)
+    {
+        return;
+    }
+    vkDeviceWaitIdle(vk_device);
+
+    if (device->submit.command_pool != VK_NULL_HANDLE)
+    {
+        vk_destroy_submit_context(vk_device, &device->submit);
+    }
+    vk_destroy_specialized_pipelines(vk_device, &device->pipelines);
+    vk_destroy_pipeline(vk_device, VK_NULL_HANDLE, device->pipeline_layout, device->descriptor_set_layout);
+    if (device->descriptor_pool != VK_NULL_HANDLE)
+    {
+        vkDestroyDescriptorPool(vk_device, device->descriptor_pool, NULL);
+    }
+
+    VkBuffer* buffers[] = { &device->input_buffer, &device->output_buffer, &device->staging_buffer, &device->palette_buffer };
+    vk_mapped_memory* memories[] = { &device->input_memory, &device->output_memory, &device->staging_memory, &device->palette_memory };
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        if (*buffers[i] != VK_NULL_HANDLE)
+        {
+            vk_destroy_buffer(vk_device, *buffers[i], memories[i]);
+        }
+    }
+
+    vkDestroyDevice(vk_device, NULL);
+    memset(device, 0, sizeof(*device));
+}
+
+int vk_begin_fractal_rows(vk_fractal_device* device, uint32_t image_width, uint32_t image_height,
+                          uint32_t row_start, uint32_t row_count, void* image)
+{
+    memset(&device->band, 0, sizeof(device->band));
+    device->image_height = image_height;
+    device->row_start = row_start;
+    device->tile_index = 0;
+    device->in_flight = 0;
+    device->image = image;
+
+    // A device that gets no rows has no tiles
+    if (row_count == 0)
+    {
+        return 0;
+    }
+
+    // The rows are planned as an image of their own, their tiles are then moved down into the full view
+    return vk_plan_tiles(device->phy_device, image_width, row_count, device->local_size_x, device->params.output, device->tile_bytes, &device->band);
+}
+
+int vk_step_fractal_rows(vk_fractal_device* device)
+{
+    VkDevice vk_device = device->device;
+    const vk_tile_plan* band = &device->band;
+
+    if (device->in_flight)
+    {
+        if (vk_wait_submit(vk_device, &device->submit, device->submit_slot) != 0)
+        {
+            return -1;
+        }
+        device->in_flight = 0;
+
+        // Copy the rows of the tile straight out of the mapped buffer into the image
+        const vk_tile_push_constants* tile = &device->tile;
+        const vk_mapped_memory* readback_memory = device->staging_buffer != VK_NULL_HANDLE ? &device->staging_memory : &device->output_memory;
+        uint32_t pixel_bytes = band->output == FRACTAL_OUTPUT_COUNT8 ? 1 : 4;
+        uint32_t row_bytes = vk_tile_row_bytes(band, tile->tile_width);
+        size_t image_row_bytes = (size_t)band->image_width * pixel_bytes;
+        vk_invalidate_mapped_memory(vk_device, readback_memory, 0, (VkDeviceSize)row_bytes * tile->tile_height);
+
+        unsigned char* image_tile = (unsigned char*)device->image + (size_t)tile->tile_y * image_row_bytes + (size_t)tile->tile_x * pixel_bytes;
+        const unsigned char* tile_data = (const unsigned char*)readback_memory->address;
+        for (uint32_t row = 0; row < tile->tile_height; row++)
+        {
+            memcpy(image_tile + row * image_row_bytes, tile_data + (size_t)row * row_bytes, (size_t)tile->tile_width * pixel_bytes);
+        }
+        device->tile_index++;
+    }
+
+    if (device->tile_index >= vk_tile_count(band))
+    {
+        return 0;
+    }
+
+    vk_tile_push_constants* tile = &device->tile;
+    vk_get_tile(band, device->tile_index, &device->params, tile);
+    tile->tile_y += device->row_start;
+    tile->image_height = device->image_height;
+
+    uint32_t tile_size = vk_tile_row_bytes(band, tile->tile_width) * tile->tile_height;
+    uint32_t group_count_x = vk_tile_group_count_x(band, tile->tile_width);
+    device->submit_slot = device->submit.next;
+    VkCommandBuffer vk_command_buffer = vk_begin_submit(vk_device, &device->submit);
+    if (vk_command_buffer == VK_NULL_HANDLE)
+    {
+        return -1;
+    }
+    vk_record_dispatch(vk_command_buffer, device->pipeline, device->pipeline_layout, device->descriptor_set, tile, sizeof(*tile),
+                       group_count_x, tile->tile_height, VK_NULL_HANDLE, 0, device->output_buffer, device->staging_buffer, tile_size);
+    if (vk_end_submit(vk_device, device->queues.compute[0], &device->submit) != 0)
+    {
+        return -1;
+    }
+    device->in_flight = 1;
+    return 1;
+}
+
+int run_multi_device(VkInstance vk_instance, const render_options* options, uint32_t* image)
+{
+    const fractal_params* params = &options->params;
+    uint32_t width = options->width;
+    uint32_t height = options->height;
+
+    VkPhysicalDevice vk_phy_devices[MAX_PHY_DEVICE];
+    uint32_t phy_device_count = vk_enumerate_physical_devices(vk_instance, vk_phy_devices, MAX_PHY_DEVICE);
+
+    uint32_t palette_entries = params->output == FRACTAL_OUTPUT_RGBA8 ? params->max_iterations + 1 : 1;
+    vk_fractal_device devices[MAX_PHY_DEVICE];
+    uint32_t device_count = 0;
+    for (uint32_t d = 0; d < phy_device_count; d++)
+    {
+        if (vk_open_fractal_device(vk_phy_devices[d], params, options->local_size_x, width, palette_entries, &devices[device_count]) == 0)
+        {
+            device_count++;
+        }
+        else
+        {
+            printf("Multi-device: device %u can't render, it gets no rows.\n", d);
+        }
+    }
+    if (device_count == 0)
+    {
+        printf("Multi-device: no device to render on.\n");
+        return -1;
+    }
+
+    uint32_t calibration_width = width < MULTI_DEVICE_CALIBRATION_SIZE ? width : MULTI_DEVICE_CALIBRATION_SIZE;
+    uint32_t calibration_height = (uint32_t)((uint64_t)height * calibration_width / width);
+    if (calibration_height == 0)
+    {
+        calibration_height = 1;
+    }
+    void* calibration_image = malloc((size_t)calibration_width * calibration_height * export_pixel_bytes(gpu_pixels(options)));
+
+    int result = calibration_image != NULL ? 0 : -1;
+    double speed[MAX_PHY_DEVICE];
+    double total_speed = 0.0;
+    for (uint32_t d = 0; d < device_count && result == 0; d++)
+    {
+        double best = 0.0;
+        for (uint32_t run = 0; run < MULTI_DEVICE_CALIBRATION_RUNS && result == 0; run++)
+        {
+            double time = getTime();
+            result = vk_begin_fractal_rows(&devices[d], calibration_width, calibration_height, 0, calibration_height, calibration_image);
+            while (result == 0 && (result = vk_step_fractal_rows(&devices[d])) > 0)
+            {
+                result = 0;
+            }
+            time = getTime() - time;
+            if (run > 0 && (best == 0.0 || time < best))
+            {
+                best = time;
+            }
+        }
+        speed[d] = best > 0.0 ? 1.0 / best : 1.0;
+        total_speed += speed[d];
+    }
+    free(calibration_image);
+
+    // The last device takes the rows left by rounding
+    uint32_t row = 0;
+    for (uint32_t d = 0; d < device_count && result == 0; d++)
+    {
+        uint32_t rows = d + 1 == device_count ? height - row : (uint32_t)(height * speed[d] / total_speed + 0.5);
+        if (rows > height - row)
+        {
+            rows = height - row;
+        }
+        printf("Multi-device: %s, %.1f%% of the calibration speed, rows %u to %u.\n",
+               devices[d].name, 100.0 * speed[d] / total_speed, row, row + rows);
+        result = vk_begin_fractal_rows(&devices[d], width, height, row, rows, image);
+        row += rows;
+    }
+
+    double time = getTime();
+    for (uint32_t busy = device_count; busy > 0 && result == 0; )
+    {
+        busy = 0;
+        for (uint32_t d = 0; d < device_count; d++)
+        {
+            int stepped = vk_step_fractal_rows(&devices[d]);
+            if (stepped < 0)
+            {
+                result = -1;
+                break;
+            }
+            busy += stepped;
+        }
+    }
+    time = getTime() - time;
+
+    if (result == 0)
+    {
+        printf("GPU fractal (%u devices): %f ms.\n", device_count, time / 1000.0f);
+        result = write_image(options, image, "fractal_gpu", gpu_pixels(options));
+    }
+
+    for (uint32_t d = 0; d < device_count; d++)
+    {
+        vk_close_fractal_device(&devices[d]);
+    }
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,74 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <vulkan/vulkan.h>
+#include "vkrt/compute.h"
+#include "vkrt/device.h"
+#include "vkrt/memory.h"
+#include "fractal_params.h"
+#include "pipeline.h"
+#include "tile.h"
+#include "render.h"
+
+// One physical device rendering its own rows of an image: a logical device with the buffers, pipeline
+// and submit ring of a plain render, tiles streamed through one tile-sized output buffer
+typedef struct vk_fractal_device {
+    VkPhysicalDevice phy_device;
+    char name[VK_MAX_PHYSICAL_DEVICE_NAME_SIZE];
+    VkDevice device;
+    vk_device_queues queues;
+    VkDescriptorSetLayout descriptor_set_layout;
+    VkDescriptorPool descriptor_pool;
+    VkDescriptorSet descriptor_set;
+    VkPipelineLayout pipeline_layout;
+    vk_specialized_pipelines pipelines;
+    VkPipeline pipeline;
+    vk_submit_context submit;
+    VkBuffer input_buffer;
+    vk_mapped_memory input_memory;
+    VkBuffer output_buffer;
+    vk_mapped_memory output_memory;
+    VkBuffer staging_buffer;            // VK_NULL_HANDLE when the output buffer is read directly
+    vk_mapped_memory staging_memory;
+    VkBuffer palette_buffer;
+    vk_mapped_memory palette_memory;
+    VkDeviceSize tile_bytes;            // Capacity of the output buffer
+    uint32_t local_size_x;
+
+    // Rows being rendered, see vk_begin_fractal_rows
+    fractal_params params;
+    vk_tile_plan band;
+    uint32_t image_height;
+    uint32_t row_start;
+    uint32_t tile_index;
+    uint32_t submit_slot;
+    int in_flight;
+    vk_tile_push_constants tile;
+    void* image;
+} vk_fractal_device;
+
+// Creates the device with a pipeline for params and a palette of palette_entries colors, sized for
+// images up to max_width pixels wide. Returns -1 and leaves nothing to destroy on failure.
+int vk_open_fractal_device(VkPhysicalDevice vk_phy_device, const fractal_params* params, uint32_t local_size_x,
+                           uint32_t max_width, uint32_t palette_entries, vk_fractal_device* device);
+void vk_close_fractal_device(vk_fractal_device* device);
+
+// Starts rendering rows [row_start, row_start + row_count) of an image_width x image_height view into
+// image, which holds the whole image in the output format with unpadded rows
+int vk_begin_fractal_rows(vk_fractal_device* device, uint32_t image_width, uint32_t image_height,
+                          uint32_t row_start, uint32_t row_count, void* image);
+// Reads back the tile in flight and submits the next one, so devices stepped in turn render at the same
+// time. Returns 1 while tiles remain, 0 once every row is in the image, -1 on failure.
+int vk_step_fractal_rows(vk_fractal_device* device);
+
+// Renders the image on every physical device at once. Each one first renders a reduced copy of the view
+// by itself, then gets a band of rows in proportion to its speed. The devices write their rows straight
+// into image and are stepped in turn, one tile each, so they all render at the same time.
+int run_multi_device(VkInstance vk_instance, const render_options* options, uint32_t* image);
+
+#ifdef __cplusplus
+}
+#endif
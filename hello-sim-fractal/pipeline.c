@@ -4,82 +4,122 @@ extern "C" {
 
 #include "pipeline.h"
 #include <stdio.h>
+#include <stddef.h>
 #include <string.h>
-#include "device.h"
-
-VkShaderModule vk_create_compute_shader(VkDevice vk_device, const char* filename)
+#include "vkrt/kernel.h"
+
+// Layout of the specialization constants in shader/fractal.comp
+typedef struct fractal_specialization_data {
+    uint32_t local_size_x;      // constant_id = 0
+    uint32_t max_iterations;    // constant_id = 1
+    float c_real;               // constant_id = 2
+    float c_imag;               // constant_id = 3
+    uint32_t output;            // constant_id = 4
+} fractal_specialization_data;
+
+void vk_init_specialized_pipelines(vk_specialized_pipelines* pipelines, VkShaderModule vk_shader_module, VkPipelineLayout vk_pipeline_layout,
+                                   VkDescriptorSetLayout vk_descriptor_set_layout, VkPipelineCache vk_pipeline_cache)
 {
-    uint8_t shaderData[20000];
+    memset(pipelines, 0, sizeof(*pipelines));
+    pipelines->shader_module = vk_shader_module;
+    pipelines->pipeline_layout = vk_pipeline_layout;
+    pipelines->descriptor_set_layout = vk_descriptor_set_layout;
+    pipelines->pipeline_cache = vk_pipeline_cache;
+}
 
-    FILE *f = fopen(filename, "rb");
-    if (f == NULL)
+VkPipeline vk_get_specialized_pipeline(VkDevice vk_device, vk_specialized_pipelines* pipelines, uint32_t local_size_x, const fractal_params* params)
+{
+    // The shader sees float constants, so compare what it will actually get
+    fractal_specialization_data data;
+    data.local_size_x = local_size_x;
+    data.max_iterations = params->max_iterations;
+    data.c_real = (float)params->c_real;
+    data.c_imag = (float)params->c_imag;
+    data.output = (uint32_t)params->output;
+
+    uint32_t slot = 0;
+    for (uint32_t i = 0; i < pipelines->count; i++)
     {
-        printf("Failed to open the shader file.\n");
-        return VK_NULL_HANDLE;
+        vk_specialized_pipeline* entry = &pipelines->slots[i];
+        if (entry->local_size_x == data.local_size_x &&
+            entry->params.max_iterations == data.max_iterations &&
+            (float)entry->params.c_real == data.c_real &&
+            (float)entry->params.c_imag == data.c_imag &&
+            entry->params.output == params->output)
+        {
+            entry->last_use = ++pipelines->use_counter;
+            return entry->pipeline;
+        }
+        if (entry->last_use < pipelines->slots[slot].last_use)
+        {
+            slot = i;
+        }
     }
 
-    size_t size = fread(shaderData, 1, sizeof(shaderData), f);
-    fclose(f);
-
-    VkShaderModuleCreateInfo createInfo;
-    memset(&createInfo, 0, sizeof(createInfo));
-
-    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = size;
-    createInfo.pCode = (uint32_t*)shaderData;
-
-    VkShaderModule handle;
+    if (pipelines->count < SPECIALIZED_PIPELINE_SLOTS)
+    {
+        slot = pipelines->count;
+    }
+    else
+    {
+        vkDestroyPipeline(vk_device, pipelines->slots[slot].pipeline, NULL);
+        pipelines->count--;
+        pipelines->slots[slot] = pipelines->slots[pipelines->count];
+        slot = pipelines->count;
+    }
 
-    if (vkCreateShaderModule(vk_device, &createInfo, NULL, &handle) != VK_SUCCESS)
+    VkSpecializationMapEntry entries[5];
+    entries[0].constantID = 0;
+    entries[0].offset = offsetof(fractal_specialization_data, local_size_x);
+    entries[0].size = sizeof(uint32_t);
+    entries[1].constantID = 1;
+    entries[1].offset = offsetof(fractal_specialization_data, max_iterations);
+    entries[1].size = sizeof(uint32_t);
+    entries[2].constantID = 2;
+    entries[2].offset = offsetof(fractal_specialization_data, c_real);
+    entries[2].size = sizeof(float);
+    entries[3].constantID = 3;
+    entries[3].offset = offsetof(fractal_specialization_data, c_imag);
+    entries[3].size = sizeof(float);
+    entries[4].constantID = 4;
+    entries[4].offset = offsetof(fractal_specialization_data, output);
+    entries[4].size = sizeof(uint32_t);
+
+    VkSpecializationInfo specialization;
+    memset(&specialization, 0, sizeof(specialization));
+    specialization.mapEntryCount = 5;
+    specialization.pMapEntries = entries;
+    specialization.dataSize = sizeof(data);
+    specialization.pData = &data;
+
+    VkPipeline vk_pipeline = vk_create_pipline(vk_device, pipelines->pipeline_layout, pipelines->descriptor_set_layout, pipelines->shader_module,
+                                               pipelines->pipeline_cache, &specialization);
+    if (vk_pipeline == VK_NULL_HANDLE)
     {
-        printf("Failed to create the shader module.\n");
         return VK_NULL_HANDLE;
     }
-    return handle;
-}
-
-VkPipelineLayout vk_create_pipeline_layout(VkDevice vk_device, VkDescriptorSetLayout vk_descriptor_set_layout)
-{
-	VkPipelineLayout vk_pipeline_layout;
 
-    VkPipelineLayoutCreateInfo createLayout;
-    memset(&createLayout, 0, sizeof(createLayout));
+    vk_specialized_pipeline* entry = &pipelines->slots[slot];
+    entry->local_size_x = local_size_x;
+    entry->params = *params;
+    entry->pipeline = vk_pipeline;
+    entry->last_use = ++pipelines->use_counter;
+    pipelines->count++;
 
-    createLayout.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    createLayout.pSetLayouts = &vk_descriptor_set_layout;
-    createLayout.setLayoutCount = 1;
+    return vk_pipeline;
+}
 
-    if (vkCreatePipelineLayout(vk_device, &createLayout, NULL, &vk_pipeline_layout) != VK_SUCCESS)
+void vk_destroy_specialized_pipelines(VkDevice vk_device, vk_specialized_pipelines* pipelines)
+{
+    for (uint32_t i = 0; i < pipelines->count; i++)
     {
-        printf("Failed to create the pipeline layout.\n");
-        return VK_NULL_HANDLE;
+        vkDestroyPipeline(vk_device, pipelines->slots[i].pipeline, NULL);
     }
-	return vk_pipeline_layout;
-}
- 
-VkPipeline vk_create_pipline(VkDevice vk_device, VkPipelineLayout vk_pipeline_layout, VkDescriptorSetLayout vk_descriptor_set_layout, VkShaderModule vk_shader_module)
-{
-    VkPipeline vk_pipeline;
-
-    VkComputePipelineCreateInfo createPipeline;
-    memset(&createPipeline, 0, sizeof(createPipeline));
-    createPipeline.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-    createPipeline.layout = vk_pipeline_layout;
-    createPipeline.basePipelineIndex = -1;
-    createPipeline.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    createPipeline.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
-    createPipeline.stage.pName = "main";
-    createPipeline.stage.module = vk_shader_module;
-
-    if (vkCreateComputePipelines(vk_device, VK_NULL_HANDLE, 1, &createPipeline, NULL, &vk_pipeline) != VK_SUCCESS)
+    if (pipelines->shader_module != VK_NULL_HANDLE)
     {
-        printf("Failed to create a pipeline.\n");
-        return VK_NULL_HANDLE;
+        vkDestroyShaderModule(vk_device, pipelines->shader_module, NULL);
     }
-
-    vkDestroyShaderModule(vk_device, createPipeline.stage.module, NULL);
-
-	return vk_pipeline;
+    memset(pipelines, 0, sizeof(*pipelines));
 }
 
 void vk_destroy_pipeline(VkDevice vk_device, VkPipeline vk_pipeline, VkPipelineLayout vk_pipeline_layout, VkDescriptorSetLayout vk_descriptor_set_layout)
@@ -98,6 +138,77 @@ void vk_destroy_pipeline(VkDevice vk_device, VkPipeline vk_pipeline, VkPipelineL
     }
 }
 
+void vk_update_descriptor_set(
+    VkDevice vk_device, 
+    VkDescriptorSet vk_descriptor_set, 
+    uint32_t vk_input_size, 
+    uint32_t vk_output_size, 
+    uint32_t vk_palette_size,
+    VkBuffer vk_input_buffer, 
+    VkBuffer vk_output_buffer,
+    VkBuffer vk_palette_buffer)
+{
+    VkDescriptorBufferInfo descriptorBuffers[3];
+    descriptorBuffers[0].buffer = vk_input_buffer;
+    descriptorBuffers[0].offset = 0;
+    descriptorBuffers[0].range = vk_input_size;
+
+    descriptorBuffers[1].buffer = vk_output_buffer;
+    descriptorBuffers[1].offset = 0;
+    descriptorBuffers[1].range = vk_output_size;
+
+    descriptorBuffers[2].buffer = vk_palette_buffer;
+    descriptorBuffers[2].offset = 0;
+    descriptorBuffers[2].range = vk_palette_size;
+
+    VkWriteDescriptorSet writeDescriptorSet;
+    memset(&writeDescriptorSet, 0, sizeof(writeDescriptorSet));
+
+    writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writeDescriptorSet.dstSet = vk_descriptor_set;
+    writeDescriptorSet.dstBinding = 0;
+    writeDescriptorSet.descriptorCount = 3;
+    writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writeDescriptorSet.pBufferInfo = descriptorBuffers;
+
+    vkUpdateDescriptorSets(vk_device, 1, &writeDescriptorSet, 0, NULL);
+}
+
+void vk_clone_descriptor_set(
+    VkDevice vk_device,
+    VkDescriptorSet vk_source_set,
+    VkDescriptorSet vk_descriptor_set,
+    uint32_t vk_output_size,
+    VkBuffer vk_output_buffer)
+{
+    VkCopyDescriptorSet copyDescriptorSet;
+    memset(&copyDescriptorSet, 0, sizeof(copyDescriptorSet));
+
+    copyDescriptorSet.sType = VK_STRUCTURE_TYPE_COPY_DESCRIPTOR_SET;
+    copyDescriptorSet.srcSet = vk_source_set;
+    copyDescriptorSet.dstSet = vk_descriptor_set;
+    copyDescriptorSet.descriptorCount = 3;
+
+    VkDescriptorBufferInfo outputBuffer;
+    outputBuffer.buffer = vk_output_buffer;
+    outputBuffer.offset = 0;
+    outputBuffer.range = vk_output_size;
+
+    VkWriteDescriptorSet writeDescriptorSet;
+    memset(&writeDescriptorSet, 0, sizeof(writeDescriptorSet));
+
+    writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writeDescriptorSet.dstSet = vk_descriptor_set;
+    writeDescriptorSet.dstBinding = 1;
+    writeDescriptorSet.descriptorCount = 1;
+    writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writeDescriptorSet.pBufferInfo = &outputBuffer;
+
+    // Copies are applied after the writes, so copy first and write in a second call
+    vkUpdateDescriptorSets(vk_device, 0, NULL, 1, &copyDescriptorSet);
+    vkUpdateDescriptorSets(vk_device, 1, &writeDescriptorSet, 0, NULL);
+}
+
 #ifdef __cplusplus
 }
 #endif
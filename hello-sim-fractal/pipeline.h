@@ -5,13 +5,59 @@ extern "C" {
 #endif
 
 #include <vulkan/vulkan.h>
+#include "fractal_params.h"
+#include "vkrt/kernel.h"
+
+// Number of parameter sets kept compiled at once
+#define SPECIALIZED_PIPELINE_SLOTS 8
+
+typedef struct vk_specialized_pipeline {
+    uint32_t local_size_x;
+    fractal_params params;
+    VkPipeline pipeline;
+    uint64_t last_use;
+} vk_specialized_pipeline;
+
+// Pipelines of one shader module specialized for different parameters, evicted least recently used first
+typedef struct vk_specialized_pipelines {
+    VkShaderModule shader_module;
+    VkPipelineLayout pipeline_layout;
+    VkDescriptorSetLayout descriptor_set_layout;
+    VkPipelineCache pipeline_cache;
+    vk_specialized_pipeline slots[SPECIALIZED_PIPELINE_SLOTS];
+    uint32_t count;
+    uint64_t use_counter;
+} vk_specialized_pipelines;
 
 VkDescriptorSetLayout vk_create_descriptor_set_layout(VkDevice vk_device);
-VkPipelineLayout vk_create_pipeline_layout(VkDevice vk_device, VkDescriptorSetLayout vk_descriptor_set_layout);
 
-VkShaderModule vk_create_compute_shader(VkDevice vk_device, const char* filename);
+void vk_update_descriptor_set(
+    VkDevice vk_device, 
+    VkDescriptorSet vk_descriptor_set, 
+    uint32_t vk_input_size, 
+    uint32_t vk_output_size, 
+    uint32_t vk_palette_size,
+    VkBuffer vk_input_buffer, 
+    VkBuffer vk_output_buffer,
+    VkBuffer vk_palette_buffer
+);
+
+// Copies the bindings of a descriptor set and points the copy's output binding at another buffer
+void vk_clone_descriptor_set(
+    VkDevice vk_device,
+    VkDescriptorSet vk_source_set,
+    VkDescriptorSet vk_descriptor_set,
+    uint32_t vk_output_size,
+    VkBuffer vk_output_buffer
+);
+
+// Takes ownership of the shader module
+void vk_init_specialized_pipelines(vk_specialized_pipelines* pipelines, VkShaderModule vk_shader_module, VkPipelineLayout vk_pipeline_layout,
+                                   VkDescriptorSetLayout vk_descriptor_set_layout, VkPipelineCache vk_pipeline_cache);
+// Returns the pipeline for these parameters, compiling it on first use; the device must be idle when a slot gets evicted
+VkPipeline vk_get_specialized_pipeline(VkDevice vk_device, vk_specialized_pipelines* pipelines, uint32_t local_size_x, const fractal_params* params);
+void vk_destroy_specialized_pipelines(VkDevice vk_device, vk_specialized_pipelines* pipelines);
 
-VkPipeline vk_create_pipline(VkDevice vk_device, VkPipelineLayout vk_pipeline_layout, VkDescriptorSetLayout vk_descriptor_set_layout, VkShaderModule vk_shader_module);
 void vk_destroy_pipeline(VkDevice vk_device, VkPipeline vk_pipeline, VkPipelineLayout vk_pipeline_layout, VkDescriptorSetLayout vk_descriptor_set_layout);
 
 #ifdef __cplusplus
@@ -0,0 +1,227 @@
+#include "render.h"
+#include "adaptive.h"
+
+#include <chrono>
+#include <cmath>
+
+#include <stdio.h>
+#include <string.h>
+
+render_options render_default_options(void)
+{
+    render_options options = {};
+    options.width = 256;
+    options.height = 256;
+    options.params = fractal_default_params();
+    options.local_size_x = FRACTAL_LOCAL_SIZE_X;
+    options.cpu_level = CPU_SIMD_AUTO;
+    options.output_format = EXPORT_FORMAT_PNG;
+    options.serve_jobs = 2;
+    options.bench_warmup = 3;
+    options.bench_iterations = 20;
+    return options;
+}
+
+double getTime(void)
+{
+     // Get the current time from a monotonic clock
+     auto now = std::chrono::steady_clock::now();
+
+     // Convert the current time to time since epoch
+     auto duration = now.time_since_epoch();
+
+     // Convert duration to microseconds, keeping the sub-microsecond part
+     auto microseconds = std::chrono::duration<double, std::micro>(duration).count();
+
+	 return microseconds;
+}
+
+export_pixels gpu_pixels(const render_options* options)
+{
+    if (options->equalize)
+    {
+        return EXPORT_PIXELS_RGBA8;
+    }
+
+    switch (options->params.output)
+    {
+    case FRACTAL_OUTPUT_COUNT8:
+        return EXPORT_PIXELS_GRAY8;
+
+    case FRACTAL_OUTPUT_RGBA8:
+        return EXPORT_PIXELS_RGBA8;
+
+    default:
+        return EXPORT_PIXELS_PACKED;
+    }
+}
+
+void copy_tile_to_image(VkDevice vk_device, void* image, export_pixels layout, const vk_tile_plan* plan,
+                        const vk_tile_push_constants* tile, const vk_mapped_memory* vk_readback_memory)
+{
+    uint32_t pixel_bytes = export_pixel_bytes(layout);
+    uint32_t row_bytes = vk_tile_row_bytes(plan, tile->tile_width);
+    uint32_t tile_size = row_bytes * tile->tile_height;
+    size_t image_row_bytes = (size_t)plan->image_width * pixel_bytes;
+    unsigned char* image_tile = (unsigned char*)image + (size_t)tile->tile_y * image_row_bytes + (size_t)tile->tile_x * pixel_bytes;
+
+    if (row_bytes == image_row_bytes)
+    {
+        // Full-width unpadded tiles are contiguous in the image
+        vk_copy_from_output_buffer(vk_device, image_tile, tile_size, vk_readback_memory);
+    }
+    else
+    {
+        // Copy the rows straight out of the mapped tile
+        vk_invalidate_mapped_memory(vk_device, vk_readback_memory, 0, tile_size);
+
+        const unsigned char* vk_tile_data = (const unsigned char*)vk_readback_memory->address;
+        for (uint32_t row = 0; row < tile->tile_height; row++)
+        {
+            memcpy(image_tile + row * image_row_bytes, vk_tile_data + (size_t)row * row_bytes, (size_t)tile->tile_width * pixel_bytes);
+        }
+    }
+}
+
+int write_image(const render_options* options, const void* image, const char* name, export_pixels layout)
+{
+    char filename[64];
+    snprintf(filename, sizeof(filename), "%s.%s", name, export_format_extension(options->output_format, layout));
+    return export_write_image(filename, image, options->width, options->height, layout, options->output_format);
+}
+
+fractal_params zoom_params(const render_options* options, uint32_t frame, uint32_t frame_count)
+{
+    const fractal_params* params = &options->params;
+    fractal_params frame_params = *params;
+    if (frame_count > 1)
+    {
+        double t = (double)frame / (frame_count - 1);
+        double end_scale = options->zoom_scale > 0.0 ? options->zoom_scale : params->scale / 1000.0;
+        uint32_t end_iterations = options->zoom_max_iterations > 0 ? options->zoom_max_iterations : params->max_iterations;
+
+        frame_params.scale = params->scale * pow(end_scale / params->scale, t);
+        frame_params.max_iterations = (uint32_t)(params->max_iterations + ((double)end_iterations - params->max_iterations) * t + 0.5);
+    }
+    return frame_params;
+}
+
+void generate_fractal_cpu(const render_options* options, uint32_t* image)
+{
+    cpu_generate_fractal(image, options->width, options->height, &options->params, options->cpu_level, options->cpu_threads);
+}
+
+uint64_t generate_fractal_cpu_adaptive(const render_options* options, uint32_t* image)
+{
+    return cpu_generate_fractal_adaptive(image, options->width, options->height, &options->params, options->cpu_level, options->cpu_threads);
+}
+
+int generate_fractal_gpu(const render_context* context, VkPipeline vk_pipeline, const fractal_params* view, VkQueryPool vk_query_pool)
+{
+    VkDevice vk_device = context->device;
+    const vk_tile_plan* plan = context->plan;
+
+    // Stream the tiles through the single tile-sized output buffer
+    for (uint32_t t = 0; t < vk_tile_count(plan); t++)
+    {
+        vk_tile_push_constants tile;
+        vk_get_tile(plan, t, view, &tile);
+
+        uint32_t tile_size = vk_tile_row_bytes(plan, tile.tile_width) * tile.tile_height;
+        uint32_t group_count_x = vk_tile_group_count_x(plan, tile.tile_width);
+        VkCommandBuffer vk_command_buffer = vk_begin_submit(vk_device, context->submit);
+        if (vk_command_buffer == VK_NULL_HANDLE)
+        {
+            return -1;
+        }
+        vk_record_dispatch(vk_command_buffer, vk_pipeline, context->pipeline_layout, context->descriptor_set, &tile, sizeof(tile),
+                           group_count_x, tile.tile_height, vk_query_pool, 2 * t, context->output_buffer, context->staging_buffer, tile_size);
+
+        // The next tile reuses the output buffer, so wait before reading this one back
+        if (vk_end_submit(vk_device, context->queues->compute[0], context->submit) != 0 ||
+            vk_wait_submit_context(vk_device, context->submit) != 0)
+        {
+            return -1;
+        }
+
+        copy_tile_to_image(vk_device, context->image, gpu_pixels(context->options), plan, &tile, context->readback_memory);
+    }
+    return 0;
+}
+
+int generate_fractal_gpu_adaptive(const render_context* context, VkPipeline vk_border_pipeline, VkPipeline vk_fill_pipeline,
+                                  const fractal_params* view, VkQueryPool vk_query_pool, uint64_t* unresolved_blocks)
+{
+    VkDevice vk_device = context->device;
+    const vk_tile_plan* plan = context->plan;
+
+    *unresolved_blocks = 0;
+    for (uint32_t t = 0; t < vk_tile_count(plan); t++)
+    {
+        vk_tile_push_constants tile;
+        vk_get_tile(plan, t, view, &tile);
+
+        uint32_t tile_size = vk_tile_row_bytes(plan, tile.tile_width) * tile.tile_height;
+        VkCommandBuffer vk_command_buffer = vk_begin_submit(vk_device, context->submit);
+        if (vk_command_buffer == VK_NULL_HANDLE)
+        {
+            return -1;
+        }
+        vk_record_adaptive(vk_command_buffer, vk_border_pipeline, vk_fill_pipeline, context->pipeline_layout, context->descriptor_set, &tile,
+                           context->input_buffer, vk_query_pool, 2 * t, context->output_buffer, context->staging_buffer, tile_size);
+
+        // The next tile reuses the output and work buffers
+        if (vk_end_submit(vk_device, context->queues->compute[0], context->submit) != 0 ||
+            vk_wait_submit_context(vk_device, context->submit) != 0)
+        {
+            return -1;
+        }
+
+        copy_tile_to_image(vk_device, context->image, gpu_pixels(context->options), plan, &tile, context->readback_memory);
+
+        vk_invalidate_mapped_memory(vk_device, context->input_memory, 0, sizeof(VkDispatchIndirectCommand));
+        *unresolved_blocks += ((const VkDispatchIndirectCommand*)context->input_memory->address)->x;
+    }
+    return 0;
+}
+
+int generate_fractal_gpu_equalized(const render_context* context, const vk_equalize_pipelines* vk_pipelines,
+                                   const fractal_params* view, VkQueryPool vk_query_pool)
+{
+    VkDevice vk_device = context->device;
+    const vk_tile_plan* plan = context->plan;
+
+    uint32_t tile_count = vk_tile_count(plan);
+    for (uint32_t t = 0; t < tile_count; t++)
+    {
+        vk_tile_push_constants tile;
+        vk_get_tile(plan, t, view, &tile);
+
+        uint32_t tile_size = vk_tile_row_bytes(plan, tile.tile_width) * tile.tile_height;
+        VkCommandBuffer vk_command_buffer = vk_begin_submit(vk_device, context->submit);
+        if (vk_command_buffer == VK_NULL_HANDLE)
+        {
+            return -1;
+        }
+        vk_record_equalized_tile(vk_command_buffer, vk_pipelines, context->pipeline_layout, context->descriptor_set, plan, &tile, t,
+                                 context->input_buffer, vk_query_pool, 2 * t, context->output_buffer, context->staging_buffer, tile_size);
+
+        // The next tile reuses the output buffer
+        if (vk_end_submit(vk_device, context->queues->compute[0], context->submit) != 0 ||
+            vk_wait_submit_context(vk_device, context->submit) != 0)
+        {
+            return -1;
+        }
+
+        copy_tile_to_image(vk_device, context->image, gpu_pixels(context->options), plan, &tile, context->readback_memory);
+    }
+
+    if (tile_count > 1)
+    {
+        const render_options* options = context->options;
+        vk_invalidate_mapped_memory(vk_device, context->input_memory, 0, vk_equalize_buffer_size(view->max_iterations));
+        equalize_colorize_image(context->image, (size_t)options->width * options->height, (const uint32_t*)context->input_memory->address,
+                                view->max_iterations);
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <vulkan/vulkan.h>
+#include "vkrt/compute.h"
+#include "vkrt/device.h"
+#include "vkrt/memory.h"
+#include "fractal_params.h"
+#include "fractal_cpu.h"
+#include "export.h"
+#include "pipeline.h"
+#include "equalize.h"
+#include "tile.h"
+
+// Options of a run, filled in from the command line
+typedef struct render_options {
+    uint32_t width;
+    uint32_t height;
+    fractal_params params;              // Kernel parameters and view
+    uint32_t local_size_x;
+    cpu_simd_level cpu_level;
+    uint32_t cpu_threads;
+    int adaptive;                       // Mariani-Silver rendering that fills rectangles with a uniform border, --adaptive
+    int equalize;                       // Histogram-equalized RGBA coloring computed on the GPU after the render, --equalize
+    export_format output_format;
+    const char* frame_pattern;          // Numbers the frames of an animation, NULL for fractal_%04u with the extension of output_format
+    uint32_t export_threads;
+    uint32_t animate_frames;            // Zoom animation, rendered when > 0
+    double zoom_scale;                  // Scale of the last frame, 0 zooms in 1000x
+    uint32_t zoom_max_iterations;       // Iteration count of the last frame, 0 keeps params.max_iterations
+    int single_queue;                   // Animation tiles are copied back on a transfer queue unless --single-queue
+    const char* serve_stream;           // Job stream of the headless render service, - for stdin, NULL without --serve
+    uint32_t serve_jobs;                // Jobs rendered at once, each with its own output buffer
+    uint32_t bench_warmup;
+    uint32_t bench_iterations;
+    const char* bench_json;
+    uint32_t bench_dispatches;
+    uint32_t bench_batch_jobs;          // Renders of width x height per batch, 0 skips the batch benchmark
+} render_options;
+
+render_options render_default_options(void);
+
+// Device objects of a run, created once and shared by every mode
+typedef struct render_context {
+    const render_options* options;
+    VkPhysicalDevice phy_device;
+    VkDevice device;
+    const vk_device_queues* queues;
+    vk_specialized_pipelines* pipelines;        // shader/fractal.comp, specialized per parameter set
+    VkPipelineLayout pipeline_layout;
+    VkDescriptorSetLayout descriptor_set_layout;
+    VkDescriptorPool descriptor_pool;           // Has room for a set per animation readback slot or service job
+    VkDescriptorSet descriptor_set;
+    VkCommandPool command_pool;
+    vk_submit_context* submit;                  // On the first compute queue
+    VkBuffer input_buffer;                      // Carries the work list in adaptive mode and the histogram in equalize mode
+    const vk_mapped_memory* input_memory;
+    VkBuffer output_buffer;                     // One tile
+    VkBuffer staging_buffer;                    // VK_NULL_HANDLE when the output buffer is read directly
+    const vk_mapped_memory* readback_memory;
+    const vk_tile_plan* plan;
+    uint32_t* image;                            // Host copy of the GPU output, width x height pixels
+} render_context;
+
+// Microseconds on a monotonic clock
+double getTime(void);
+
+// Layout of the GPU output once it is in host memory
+export_pixels gpu_pixels(const render_options* options);
+
+// Copies a tile that was read back into its place in the plan's image of GPU output
+void copy_tile_to_image(VkDevice vk_device, void* image, export_pixels layout, const vk_tile_plan* plan,
+                        const vk_tile_push_constants* tile, const vk_mapped_memory* vk_readback_memory);
+
+// Writes the image in the output format, adding the extension to name
+int write_image(const render_options* options, const void* image, const char* name, export_pixels layout);
+
+// View of one of frame_count frames along the zoom path, zooming geometrically into params.center
+fractal_params zoom_params(const render_options* options, uint32_t frame, uint32_t frame_count);
+
+void generate_fractal_cpu(const render_options* options, uint32_t* image);
+// Returns the number of pixels that were iterated
+uint64_t generate_fractal_cpu_adaptive(const render_options* options, uint32_t* image);
+
+// Streams the tiles of the view through the output buffer into context->image
+int generate_fractal_gpu(const render_context* context, VkPipeline vk_pipeline, const fractal_params* view, VkQueryPool vk_query_pool);
+// generate_fractal_gpu with the two adaptive passes per tile, counting the blocks that needed the fill pass
+int generate_fractal_gpu_adaptive(const render_context* context, VkPipeline vk_border_pipeline, VkPipeline vk_fill_pipeline,
+                                  const fractal_params* view, VkQueryPool vk_query_pool, uint64_t* unresolved_blocks);
+// generate_fractal_gpu with the histogram pass after every tile and the scan after the last one. A single
+// tile is colored on the GPU, larger images are colored on the host once the equalized palette is known.
+int generate_fractal_gpu_equalized(const render_context* context, const vk_equalize_pipelines* vk_pipelines,
+                                   const fractal_params* view, VkQueryPool vk_query_pool);
+
+#ifdef __cplusplus
+}
+#endif
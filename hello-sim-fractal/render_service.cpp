@@ -0,0 +1,218 @@
+#include "render_service.h"
+#include "service.h"
+
+#include <vector>
+
+#include <stdio.h>
+#include <string.h>
+
+// Output buffer of each job slot of the service, larger jobs render in several tiles
+#define SERVICE_TILE_BYTES (16u * 1024u * 1024u)
+
+int run_service(const render_context* context)
+{
+    const render_options* options = context->options;
+    VkDevice vk_device = context->device;
+
+    // One pipeline serves every job, the iteration count of a job is a push constant below the cap
+    VkPipeline vk_pipeline = vk_get_specialized_pipeline(vk_device, context->pipelines, options->local_size_x, &options->params);
+    if (vk_pipeline == VK_NULL_HANDLE)
+    {
+        return -1;
+    }
+
+    struct service_slot {
+        VkBuffer output_buffer;
+        vk_mapped_memory output_memory;
+        VkBuffer staging_buffer;            // VK_NULL_HANDLE when the output buffer is read directly
+        vk_mapped_memory staging_memory;
+        VkDescriptorSet descriptor_set;
+        vk_submit_context submit;
+        VkQueue queue;
+        bool active;
+        render_job job;
+        vk_tile_plan plan;
+        vk_tile_push_constants tile;        // Tile in flight
+        uint32_t tile_index;
+        uint32_t submit_slot;
+        std::vector<unsigned char> image;   // Kept between jobs, it only grows
+        double start;
+    } slots[SERVICE_MAX_JOBS] = {};
+
+    int result = 0;
+    for (uint32_t s = 0; s < options->serve_jobs && result == 0; s++)
+    {
+        service_slot* slot = &slots[s];
+        slot->queue = context->queues->compute[s % context->queues->compute_count];
+        slot->output_buffer = vk_create_buffer_and_memory(context->phy_device, vk_device, SERVICE_TILE_BYTES,
+                                                          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                                          MEMORY_PLACEMENT_DEVICE, &slot->output_memory);
+        if (slot->output_buffer != VK_NULL_HANDLE && slot->output_memory.address == NULL)
+        {
+            slot->staging_buffer = vk_create_buffer_and_memory(context->phy_device, vk_device, SERVICE_TILE_BYTES, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                               MEMORY_PLACEMENT_HOST_CACHED, &slot->staging_memory);
+        }
+        slot->descriptor_set = vk_create_descriptor_set(vk_device, context->descriptor_set_layout, context->descriptor_pool);
+        if (slot->output_buffer == VK_NULL_HANDLE || (slot->output_memory.address == NULL && slot->staging_buffer == VK_NULL_HANDLE) ||
+            slot->descriptor_set == VK_NULL_HANDLE || vk_create_submit_context(vk_device, context->queues->compute_family, &slot->submit) != 0)
+        {
+            result = -1;
+            break;
+        }
+        vk_clone_descriptor_set(vk_device, context->descriptor_set, slot->descriptor_set, SERVICE_TILE_BYTES, slot->output_buffer);
+    }
+
+    FILE* stream = NULL;
+    if (result == 0)
+    {
+        stream = strcmp(options->serve_stream, "-") == 0 ? stdin : fopen(options->serve_stream, "r");
+        if (stream == NULL)
+        {
+            printf("Failed to open the job stream %s.\n", options->serve_stream);
+            result = -1;
+        }
+        else
+        {
+            printf("Service: reading jobs from %s, %u at once, iterations up to %u.\n",
+                   stream == stdin ? "stdin" : options->serve_stream, options->serve_jobs, options->params.max_iterations);
+        }
+    }
+
+    job_queue* queue = result == 0 ? job_queue_create(stream, &options->params, SERVICE_MAX_JOBS) : NULL;
+    uint32_t active = 0;
+    uint32_t done = 0;
+    uint32_t failed = 0;
+    bool ended = queue == NULL;
+    double time = getTime();
+
+    while (result == 0 && (!ended || active > 0))
+    {
+        // Fill the free slots, only blocking for a job when nothing is in flight
+        for (uint32_t s = 0; s < options->serve_jobs && !ended; s++)
+        {
+            service_slot* slot = &slots[s];
+            if (slot->active)
+            {
+                continue;
+            }
+
+            int popped = job_queue_pop(queue, &slot->job, active == 0);
+            if (popped < 0)
+            {
+                ended = true;
+            }
+            if (popped <= 0)
+            {
+                break;
+            }
+
+            const render_job* job = &slot->job;
+            if (job->params.max_iterations > options->params.max_iterations)
+            {
+                printf("Job %u: %u iterations, the service was started with --max-iter %u.\n", job->id, job->params.max_iterations, options->params.max_iterations);
+                failed++;
+                continue;
+            }
+            if (vk_plan_tiles(context->phy_device, job->width, job->height, options->local_size_x, options->params.output, SERVICE_TILE_BYTES, &slot->plan) != 0)
+            {
+                printf("Job %u: %ux%u can't be rendered.\n", job->id, job->width, job->height);
+                failed++;
+                continue;
+            }
+
+            slot->image.resize((size_t)job->width * job->height * export_pixel_bytes(gpu_pixels(options)));
+            slot->tile_index = 0;
+            slot->start = getTime();
+            slot->active = true;
+            slot->submit_slot = UINT32_MAX;
+            active++;
+        }
+
+        // Advance every slot by one tile: read back the tile it rendered, then submit the next
+        for (uint32_t s = 0; s < options->serve_jobs && result == 0; s++)
+        {
+            service_slot* slot = &slots[s];
+            if (!slot->active)
+            {
+                continue;
+            }
+
+            const vk_mapped_memory* vk_readback_memory = slot->staging_buffer != VK_NULL_HANDLE ? &slot->staging_memory : &slot->output_memory;
+            if (slot->submit_slot != UINT32_MAX)
+            {
+                if (vk_wait_submit(vk_device, &slot->submit, slot->submit_slot) != 0)
+                {
+                    result = -1;
+                    break;
+                }
+                copy_tile_to_image(vk_device, slot->image.data(), gpu_pixels(options), &slot->plan, &slot->tile, vk_readback_memory);
+                slot->tile_index++;
+            }
+
+            if (slot->tile_index < vk_tile_count(&slot->plan))
+            {
+                vk_get_tile(&slot->plan, slot->tile_index, &slot->job.params, &slot->tile);
+
+                uint32_t tile_size = vk_tile_row_bytes(&slot->plan, slot->tile.tile_width) * slot->tile.tile_height;
+                uint32_t group_count_x = vk_tile_group_count_x(&slot->plan, slot->tile.tile_width);
+                slot->submit_slot = slot->submit.next;
+                VkCommandBuffer vk_command_buffer = vk_begin_submit(vk_device, &slot->submit);
+                if (vk_command_buffer == VK_NULL_HANDLE)
+                {
+                    result = -1;
+                    break;
+                }
+                vk_record_dispatch(vk_command_buffer, vk_pipeline, context->pipeline_layout, slot->descriptor_set, &slot->tile, sizeof(slot->tile),
+                                   group_count_x, slot->tile.tile_height, VK_NULL_HANDLE, 0, slot->output_buffer, slot->staging_buffer, tile_size);
+                result = vk_end_submit(vk_device, slot->queue, &slot->submit);
+                continue;
+            }
+
+            // Every tile is in the image, the slot takes the next job while it is written
+            const render_job* job = &slot->job;
+            int written = export_write_image(job->output, slot->image.data(), job->width, job->height, gpu_pixels(options), options->output_format);
+            printf("Job %u: %ux%u, %u iterations, %f ms, %s %s.\n", job->id, job->width, job->height, job->params.max_iterations,
+                   (getTime() - slot->start) / 1000.0, written == 0 ? "wrote" : "failed to write", job->output);
+            if (written == 0)
+            {
+                done++;
+            }
+            else
+            {
+                failed++;
+            }
+            slot->active = false;
+            active--;
+        }
+    }
+    time = getTime() - time;
+
+    if (queue != NULL)
+    {
+        job_queue_destroy(queue);
+        printf("Service: %u jobs done, %u failed, %f s.\n", done, failed, time / 1000000.0);
+    }
+
+    // The descriptor sets go with the pool
+    for (uint32_t s = 0; s < options->serve_jobs; s++)
+    {
+        service_slot* slot = &slots[s];
+        if (slot->submit.command_pool != VK_NULL_HANDLE)
+        {
+            if (vk_wait_submit_context(vk_device, &slot->submit) != 0)
+            {
+                result = -1;
+            }
+            vk_destroy_submit_context(vk_device, &slot->submit);
+        }
+        if (slot->staging_buffer != VK_NULL_HANDLE)
+        {
+            vk_destroy_buffer(vk_device, slot->staging_buffer, &slot->staging_memory);
+        }
+        if (slot->output_buffer != VK_NULL_HANDLE)
+        {
+            vk_destroy_buffer(vk_device, slot->output_buffer, &slot->output_memory);
+        }
+    }
+    return result;
+}
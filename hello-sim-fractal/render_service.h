@@ -0,0 +1,17 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "render.h"
+
+// Renders the jobs of serve_stream until it ends, keeping the device, pipeline and buffers of the
+// first job for every other one. Up to serve_jobs jobs are in flight, each in a slot with its own
+// output buffer and submit ring on one of the compute queues. The host advances every slot by a tile
+// in turn, so one job's readback overlaps the renders of the others.
+int run_service(const render_context* context);
+
+#ifdef __cplusplus
+}
+#endif
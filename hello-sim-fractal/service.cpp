@@ -0,0 +1,172 @@
+#include "service.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <stdio.h>
+#include <string.h>
+
+int service_parse_job(const char* line, const fractal_params* defaults, render_job* job)
+{
+    memset(job, 0, sizeof(*job));
+    job->params = *defaults;
+
+    line += strspn(line, " \t");
+    if (*line == '\0' || *line == '\r' || *line == '\n' || *line == '#')
+    {
+        return 0;
+    }
+
+    int consumed = 0;
+    if (sscanf(line, "%u %u %lf %lf %lf %u %n", &job->width, &job->height, &job->params.center_real, &job->params.center_imag,
+               &job->params.scale, &job->params.max_iterations, &consumed) != 6 || consumed == 0)
+    {
+        return -1;
+    }
+
+    // The output path is the rest of the line, so it may contain spaces
+    const char* path = line + consumed;
+    size_t length = strcspn(path, "\r\n");
+    while (length > 0 && (path[length - 1] == ' ' || path[length - 1] == '\t'))
+    {
+        length--;
+    }
+    if (length == 0 || length >= sizeof(job->output) ||
+        job->width == 0 || job->height == 0 || job->params.scale <= 0.0 || job->params.max_iterations == 0)
+    {
+        return -1;
+    }
+    memcpy(job->output, path, length);
+    job->output[length] = '\0';
+    return 1;
+}
+
+// Shared with the reader thread, which may outlive the queue while it is blocked on the stream
+struct job_queue_state
+{
+    std::mutex mutex;
+    std::condition_variable job_ready;      // The renderer waits for jobs
+    std::condition_variable job_taken;      // The reader waits for room in the queue
+    std::deque<render_job> jobs;
+    uint32_t capacity = 0;
+    bool ended = false;
+    bool stopping = false;
+};
+
+struct job_queue
+{
+    std::shared_ptr<job_queue_state> state;
+    std::thread reader;
+};
+
+static void read_lines(job_queue_state* state, FILE* stream, const fractal_params& defaults)
+{
+    char line[1024];
+    uint32_t line_number = 0;
+    uint32_t id = 0;
+    while (fgets(line, sizeof(line), stream) != NULL)
+    {
+        line_number++;
+        if (strncmp(line, "quit", 4) == 0)
+        {
+            break;
+        }
+
+        render_job job;
+        int parsed = strchr(line, '\n') == NULL && !feof(stream) ? -1 : service_parse_job(line, &defaults, &job);
+        if (parsed < 0)
+        {
+            // Skip the rest of an overlong line
+            while (strchr(line, '\n') == NULL && fgets(line, sizeof(line), stream) != NULL)
+            {
+            }
+            printf("Service: line %u ignored, expected width height center_real center_imag scale iterations output_path.\n", line_number);
+            continue;
+        }
+        if (parsed == 0)
+        {
+            continue;
+        }
+        job.id = ++id;
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->job_taken.wait(lock, [&state] { return state->stopping || state->jobs.size() < state->capacity; });
+        if (state->stopping)
+        {
+            return;
+        }
+        state->jobs.push_back(job);
+        lock.unlock();
+        state->job_ready.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->ended = true;
+    }
+    state->job_ready.notify_all();
+}
+
+// The reader owns the stream, a queue destroyed while it is blocked on a line leaves it to close it once it returns
+static void read_jobs(std::shared_ptr<job_queue_state> state, FILE* stream, fractal_params defaults)
+{
+    read_lines(state.get(), stream, defaults);
+    if (stream != stdin)
+    {
+        fclose(stream);
+    }
+}
+
+job_queue* job_queue_create(FILE* stream, const fractal_params* defaults, uint32_t capacity)
+{
+    job_queue* queue = new job_queue();
+    queue->state = std::make_shared<job_queue_state>();
+    queue->state->capacity = capacity > 0 ? capacity : 1;
+    queue->reader = std::thread(read_jobs, queue->state, stream, *defaults);
+    return queue;
+}
+
+int job_queue_pop(job_queue* queue, render_job* job, int wait)
+{
+    job_queue_state* state = queue->state.get();
+    std::unique_lock<std::mutex> lock(state->mutex);
+    if (wait)
+    {
+        state->job_ready.wait(lock, [state] { return state->ended || !state->jobs.empty(); });
+    }
+    if (state->jobs.empty())
+    {
+        return state->ended ? -1 : 0;
+    }
+
+    *job = state->jobs.front();
+    state->jobs.pop_front();
+    lock.unlock();
+    state->job_taken.notify_one();
+    return 1;
+}
+
+void job_queue_destroy(job_queue* queue)
+{
+    bool ended;
+    {
+        std::lock_guard<std::mutex> lock(queue->state->mutex);
+        queue->state->stopping = true;
+        ended = queue->state->ended;
+    }
+    queue->state->job_taken.notify_all();
+
+    // A reader still waiting for a line keeps the state alive until it returns
+    if (ended)
+    {
+        queue->reader.join();
+    }
+    else
+    {
+        queue->reader.detach();
+    }
+    delete queue;
+}
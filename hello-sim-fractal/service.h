@@ -0,0 +1,42 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+#include "fractal_params.h"
+
+// Largest number of jobs the service renders at once
+#define SERVICE_MAX_JOBS 8
+
+// One render request of the service, given on a line as
+//   width height center_real center_imag scale iterations output_path
+typedef struct render_job {
+    uint32_t id;                // Position among the jobs read, from 1
+    uint32_t width;
+    uint32_t height;
+    fractal_params params;      // View and iteration count, the Julia constant and output format come from the command line
+    char output[256];
+} render_job;
+
+// Parses one line over the defaults. Returns 1 for a job, 0 for a blank or comment (#) line, -1 if the line is malformed.
+int service_parse_job(const char* line, const fractal_params* defaults, render_job* job);
+
+// Jobs read from a stream on a thread of their own, so waiting for the next line never stalls the renders
+// in flight. The reader stops at the end of the stream or at a line saying quit, and blocks while capacity
+// jobs are waiting to be taken. The queue takes over the stream and closes it once the reader stops,
+// unless it is stdin.
+typedef struct job_queue job_queue;
+
+job_queue* job_queue_create(FILE* stream, const fractal_params* defaults, uint32_t capacity);
+// Takes the next job. Returns 1 with a job, 0 if none is waiting and wait is 0, -1 once the reader has
+// stopped and every job was taken.
+int job_queue_pop(job_queue* queue, render_job* job, int wait);
+// The reader may still be blocked on the stream, it then exits on its own once the stream returns
+void job_queue_destroy(job_queue* queue);
+
+#ifdef __cplusplus
+}
+#endif
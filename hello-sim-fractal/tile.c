@@ -0,0 +1,137 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "tile.h"
+#include <stdio.h>
+#include <string.h>
+
+int vk_plan_tiles(
+    VkPhysicalDevice vk_phy_device,
+    uint32_t image_width,
+    uint32_t image_height,
+    uint32_t local_size_x,
+    fractal_output output,
+    VkDeviceSize max_tile_bytes,
+    vk_tile_plan* plan)
+{
+    memset(plan, 0, sizeof(*plan));
+    plan->output = output;
+
+    if (image_width == 0 || image_height == 0)
+    {
+        printf("Invalid image size %ux%u.\n", image_width, image_height);
+        return -1;
+    }
+
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(vk_phy_device, &deviceProperties);
+
+    if (local_size_x == 0 ||
+        local_size_x > deviceProperties.limits.maxComputeWorkGroupSize[0] ||
+        local_size_x > deviceProperties.limits.maxComputeWorkGroupInvocations)
+    {
+        printf("Unsupported workgroup size %u.\n", local_size_x);
+        return -1;
+    }
+
+    // A tile is bound as one storage buffer, so it can't exceed maxStorageBufferRange
+    VkDeviceSize max_bytes = deviceProperties.limits.maxStorageBufferRange;
+    if (max_tile_bytes < max_bytes)
+    {
+        max_bytes = max_tile_bytes;
+    }
+
+    // Each row of a tile is covered by groups of local_size_x invocations along x
+    uint32_t pixels_per_invocation = output == FRACTAL_OUTPUT_COUNT8 ? 4 : 1;
+    uint32_t bytes_per_pixel = output == FRACTAL_OUTPUT_COUNT8 ? 1 : 4;
+    uint64_t max_width = (uint64_t)deviceProperties.limits.maxComputeWorkGroupCount[0] * local_size_x * pixels_per_invocation;
+    if (max_width > max_bytes / bytes_per_pixel)
+    {
+        max_width = max_bytes / bytes_per_pixel;
+    }
+    if (output == FRACTAL_OUTPUT_COUNT8 && max_width < image_width)
+    {
+        // Keep the padded rows of partial-width tiles inside the limit
+        max_width &= ~(uint64_t)3;
+    }
+
+    // Each row of a tile is one workgroup along y
+    uint64_t tile_width = image_width < max_width ? image_width : max_width;
+    uint64_t max_rows = tile_width > 0 ? max_bytes / vk_tile_row_bytes(plan, (uint32_t)tile_width) : 0;
+    if (max_rows > deviceProperties.limits.maxComputeWorkGroupCount[1])
+    {
+        max_rows = deviceProperties.limits.maxComputeWorkGroupCount[1];
+    }
+
+    uint64_t tile_height = image_height < max_rows ? image_height : max_rows;
+    if (tile_width == 0 || tile_height == 0)
+    {
+        printf("Device limits are too small to render a tile.\n");
+        return -1;
+    }
+
+    plan->image_width = image_width;
+    plan->image_height = image_height;
+    plan->tile_width = (uint32_t)tile_width;
+    plan->tile_height = (uint32_t)tile_height;
+    plan->tiles_x = (uint32_t)((image_width + tile_width - 1) / tile_width);
+    plan->tiles_y = (uint32_t)((image_height + tile_height - 1) / tile_height);
+    plan->local_size_x = local_size_x;
+    plan->tile_size = (VkDeviceSize)vk_tile_row_bytes(plan, (uint32_t)tile_width) * tile_height;
+
+    return 0;
+}
+
+uint32_t vk_tile_count(const vk_tile_plan* plan)
+{
+    return plan->tiles_x * plan->tiles_y;
+}
+
+uint32_t vk_tile_row_bytes(const vk_tile_plan* plan, uint32_t tile_width)
+{
+    if (plan->output == FRACTAL_OUTPUT_COUNT8)
+    {
+        return (tile_width + 3) & ~3u;
+    }
+    return tile_width * (uint32_t)sizeof(uint32_t);
+}
+
+uint32_t vk_tile_group_count_x(const vk_tile_plan* plan, uint32_t tile_width)
+{
+    uint32_t invocations = plan->output == FRACTAL_OUTPUT_COUNT8 ? (tile_width + 3) / 4 : tile_width;
+    return (invocations + plan->local_size_x - 1) / plan->local_size_x;
+}
+
+void vk_get_tile(const vk_tile_plan* plan, uint32_t index, const fractal_params* params, vk_tile_push_constants* tile)
+{
+    uint32_t tx = index % plan->tiles_x;
+    uint32_t ty = index / plan->tiles_x;
+
+    tile->image_width = plan->image_width;
+    tile->image_height = plan->image_height;
+    tile->tile_x = tx * plan->tile_width;
+    tile->tile_y = ty * plan->tile_height;
+
+    // Tiles on the right and bottom edges may be partial
+    tile->tile_width = plan->image_width - tile->tile_x;
+    if (tile->tile_width > plan->tile_width)
+    {
+        tile->tile_width = plan->tile_width;
+    }
+    tile->tile_height = plan->image_height - tile->tile_y;
+    if (tile->tile_height > plan->tile_height)
+    {
+        tile->tile_height = plan->tile_height;
+    }
+
+    tile->center_real = (float)params->center_real;
+    tile->center_imag = (float)params->center_imag;
+    tile->scale = (float)params->scale;
+    tile->iterations = params->max_iterations;
+    tile->output_offset = 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
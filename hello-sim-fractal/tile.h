@@ -0,0 +1,63 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <vulkan/vulkan.h>
+#include "fractal_params.h"
+
+// Default workgroup size, fed to shader/fractal.comp as a specialization constant
+#define FRACTAL_LOCAL_SIZE_X 256
+
+// Upper bound for the output buffer of a single tile (64 MiB)
+#define FRACTAL_MAX_TILE_BYTES (64u * 1024u * 1024u)
+
+// Push constants consumed by shader/fractal.comp
+typedef struct vk_tile_push_constants {
+    uint32_t image_width;
+    uint32_t image_height;
+    uint32_t tile_x;
+    uint32_t tile_y;
+    uint32_t tile_width;
+    uint32_t tile_height;
+    float center_real;
+    float center_imag;
+    float scale;
+    uint32_t iterations;
+    uint32_t output_offset;     // In uints, 0 unless the tile shares the output buffer with others
+} vk_tile_push_constants;
+
+typedef struct vk_tile_plan {
+    uint32_t image_width;
+    uint32_t image_height;
+    uint32_t tile_width;
+    uint32_t tile_height;
+    uint32_t tiles_x;
+    uint32_t tiles_y;
+    uint32_t local_size_x;
+    fractal_output output;
+    VkDeviceSize tile_size;     // Bytes of the largest tile in the output format
+} vk_tile_plan;
+
+int vk_plan_tiles(
+    VkPhysicalDevice vk_phy_device,
+    uint32_t image_width,
+    uint32_t image_height,
+    uint32_t local_size_x,
+    fractal_output output,
+    VkDeviceSize max_tile_bytes,
+    vk_tile_plan* plan
+);
+
+uint32_t vk_tile_count(const vk_tile_plan* plan);
+// Bytes per row of a tile in the output buffer, 8-bit counts pad every row to whole uints
+uint32_t vk_tile_row_bytes(const vk_tile_plan* plan, uint32_t tile_width);
+// Workgroups along x covering a tile row, 8-bit counts render four pixels per invocation
+uint32_t vk_tile_group_count_x(const vk_tile_plan* plan, uint32_t tile_width);
+// Fills the push constants of one tile, viewed through params
+void vk_get_tile(const vk_tile_plan* plan, uint32_t index, const fractal_params* params, vk_tile_push_constants* tile);
+
+#ifdef __cplusplus
+}
+#endif